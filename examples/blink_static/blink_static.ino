@@ -0,0 +1,34 @@
+/*
+ * timer_blink_static
+ *
+ * Blinks the built-in LED every half second, and prints a message every
+ * second, using a static timer table from the arduino-timer-cpp17 library.
+ * The table is built at compile time, so there is nothing to add in setup().
+ *
+ */
+
+#include <arduino-timer-cpp17-static.hpp>
+
+void toggle_led() {
+    digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN)); // toggle the LED
+}
+
+void print_message() {
+    Serial.print("print_message: Called at: ");
+    Serial.println(millis());
+}
+
+// call the toggle_led function every 500 millis (half second), and the
+// print_message function every 1000 millis (1 second)
+Timers::StaticTimerSet<Timers::Clock::millis,
+		       Timers::StaticTimer<500, toggle_led>,
+		       Timers::StaticTimer<1000, print_message>> timerset;
+
+void setup() {
+    Serial.begin(9600);
+    pinMode(LED_BUILTIN, OUTPUT); // set LED pin to OUTPUT
+}
+
+void loop() {
+    timerset.tick_and_delay(); // tick the timers
+}
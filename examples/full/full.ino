@@ -4,9 +4,10 @@
  * Full example using the arduino-timer-cpp17 library.
  * Shows:
  *  - Setting a different number of tasks with microsecond clock
- *  - disabling a repeated function
+ *  - repeating a function a limited number of times
  *  - running a function after a delay
  *  - cancelling a task
+ *  - ticking TimerSets with different clocks together
  *
  */
 
@@ -21,6 +22,10 @@ Timers::TimerSet<1, Timers::Clock::micros> microtimerset;
 // create a TimerSet that holds 16 tasks, with millisecond clock
 Timers::TimerSet<16, Timers::Clock::millis> t_timerset;
 
+// ticks the three TimerSets, and delays until the first of their timers
+// is due (in microseconds, the finest of their clocks)
+Timers::TimerGroupTicker ticker(timerset, t_timerset, microtimerset);
+
 Timers::HandlerResult toggle_led() {
     digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN)); // toggle the LED
     return Timers::TimerStatus::repeat;
@@ -32,17 +37,6 @@ Timers::HandlerResult print_message(const char *message) {
     return Timers::TimerStatus::repeat;
 }
 
-size_t repeat_count = 1;
-Timers::HandlerResult repeat_x_times(size_t limit) {
-    Serial.print("repeat_x_times: ");
-    Serial.print(repeat_count);
-    Serial.print("/");
-    Serial.println(limit);
-
-    // remove this task after limit reached
-    return ++repeat_count <= limit ? Timers::TimerStatus::repeat : Timers::TimerStatus::completed;
-}
-
 void setup() {
     Serial.begin(9600);
     pinMode(LED_BUILTIN, OUTPUT); // set LED pin to OUTPUT
@@ -50,8 +44,9 @@ void setup() {
     // call the toggle_led function every 500 millis (half second)
     timerset.every(500, toggle_led);
 
-    // call the repeat_x_times function every 1000 millis (1 second)
-    timerset.every(1000, [](){ return repeat_x_times(10); });
+    // call the print_message function every 1000 millis (1 second), ten times;
+    // the TimerSet removes the task after the tenth call
+    timerset.every(1000, 10, [](){ return print_message("called ten times"); });
 
     // call the print_message function every 1000 millis (1 second),
     // passing it an argument string
@@ -81,7 +76,5 @@ void setup() {
 }
 
 void loop() {
-    timerset.tick();
-    t_timerset.tick();
-    microtimerset.tick();
+    ticker.tick_and_delay();
 }
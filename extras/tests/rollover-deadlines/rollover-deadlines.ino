@@ -0,0 +1,63 @@
+/*
+  Test timer rollover handling with absolute deadlines
+
+  The LED should blink every second, regardless of wrapping, and a
+  handler which adds itself again with no delay should run once per
+  tick(), as it does without TIMERSET_ABSOLUTE_DEADLINES.
+*/
+
+#define TIMERSET_ABSOLUTE_DEADLINES
+#include <arduino-timer-cpp17.hpp>
+
+Timers::Timepoint wrapping_millis();
+
+Timers::TimerSet<3, Timers::Clock::custom<wrapping_millis>> timerset; // this timer will wrap
+Timers::TimerSet<> _timerset; // to count milliseconds
+
+// starts 3 seconds before rollover; unlike the time loop of the other
+// rollover tests the clock never goes back, as a timer whose deadline
+// is ahead of the clock waits for the clock to reach it
+Timers::Timepoint _millis = -3000L;
+Timers::Timepoint wrapping_millis()
+{
+    // uses _millis controlled by _timerset
+    return _millis;
+}
+
+unsigned chain_runs = 0;
+
+Timers::TimerStatus chain()
+{
+    ++chain_runs;
+    timerset.in(0, chain); // takes the third slot, before this one is freed
+    return Timers::TimerStatus::completed;
+}
+
+void setup() {
+    Serial.begin(9600);
+    pinMode(LED_BUILTIN, OUTPUT);
+    _timerset.every(1, []()
+		       {
+			   ++_millis; // increase _millis every millisecond
+			   return Timers::TimerStatus::repeat;
+		       });
+
+    // should blink the LED every second, regardless of wrapping
+    timerset.every(1000, []()
+			 {
+			     digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+			     return Timers::TimerStatus::repeat;
+			 });
+
+    timerset.in(0, chain);
+}
+
+void loop() {
+    _timerset.tick();
+
+    chain_runs = 0;
+    timerset.tick();
+    if (chain_runs > 1) {
+	Serial.println("FAIL");
+    }
+}
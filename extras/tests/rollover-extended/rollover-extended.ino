@@ -0,0 +1,41 @@
+/*
+  Test 64-bit extended timeline across counter rollover
+*/
+
+#include <arduino-timer-cpp17.hpp>
+
+Timers::Timepoint wrapping_micros();
+
+// 64-bit timeline on top of a 32-bit microsecond counter which wraps
+Timers::TimerSet<1, Timers::Clock::extended<Timers::Clock::custom<wrapping_micros, 1000000>>> timerset;
+auto _timerset = Timers::create_default(); // to count milliseconds
+
+Timers::Timepoint _micros = -3000000L; // start at rollover - 3 seconds
+Timers::Timepoint wrapping_micros()
+{
+    // uses _micros controlled by _timerset; advances 1000x faster than
+    // real time, so the counter wraps about every 4.3 seconds
+    return _micros;
+}
+
+void setup() {
+    pinMode(LED_BUILTIN, OUTPUT);
+    _timerset.every(1, []()
+		       {
+			   _micros += 1000000; // one simulated second every millisecond
+			   return Timers::TimerStatus::repeat;
+		       });
+
+    // should toggle the LED every 10 seconds, while each delay spans
+    // more than two wraps of the simulated counter
+    timerset.every(10000ULL * 1000000ULL, []()
+			 {
+			     digitalWrite(LED_BUILTIN, !digitalRead(LED_BUILTIN));
+			     return Timers::TimerStatus::repeat;
+			 });
+}
+
+void loop() {
+    _timerset.tick();
+    timerset.tick();
+}
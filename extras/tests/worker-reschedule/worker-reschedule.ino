@@ -0,0 +1,47 @@
+/*
+  Test that a timer rescheduled by a handler on a worker pool is still
+  found as the next to expire (Linux hosts)
+
+  T is dispatched at time 1 and reschedules itself for 200 ticks later;
+  E is added at time 50 to expire at time 1050. When the result of T is
+  applied at time 100, T is the next timer to expire, at time 201.
+*/
+
+#include <chrono>
+#include <thread>
+#include <arduino-timer-cpp17-workers.hpp>
+
+Timers::Timepoint fake_time = 0;
+Timers::Timepoint fake_clock()
+{
+    return fake_time;
+}
+
+Timers::TimerSet<2, Timers::Clock::custom<fake_clock>> timerset;
+Timers::WorkerPool<1> pool;
+
+void setup() {
+    Serial.begin(9600);
+
+    timerset.in(1, []()
+		   {
+		       return Timers::HandlerResult(Timers::TimerStatus::reschedule, 200);
+		   });
+
+    fake_time = 1;
+    timerset.tick(pool); // T runs on the pool
+
+    fake_time = 50;
+    timerset.in(1000, []() { return Timers::TimerStatus::completed; });
+
+    // let T finish; its result is applied by the next tick
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    fake_time = 100;
+    auto next = timerset.tick(pool);
+
+    Serial.println(next && *next == 101 ? "PASS" : "FAIL");
+}
+
+void loop() {
+}
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+"""
+Report the flash / RAM footprint (.text, .data and .bss sizes) of a
+matrix of representative TimerSet configurations (number of timers,
+clock, handler kind and optional features), and fail if any of them
+exceeds its size budget.
+
+usage: footprint.py [--target NAME] [--budget FILE] [--update] [--tolerance PCT]
+                    [--require-budgets]
+
+Each configuration is compiled (-Os, as the Arduino IDE does) into an
+object file for every available target: 'cortex-m0' (when
+arm-none-eabi-g++ is on the PATH) and 'host' (g++, or $CXX). The sizes
+are read with the matching 'size' tool. A stub Arduino.h declaring the
+few core functions the library calls is generated, so neither the
+Arduino IDE nor a board package is needed.
+
+Budgets (total of .text + .data + .bss, in bytes, per target and
+configuration) are read from footprint-budget.json next to this script;
+a configuration which is larger than its budget by more than the
+tolerance (default 2%) fails the run with exit status 1. Configurations
+without a budget are only reported, with a warning on stderr, unless
+--require-budgets is given, which fails the run for them too (as does
+'make footprint'). A target skipped because its compiler is missing is
+also warned about. --update writes the measured sizes as the new
+budgets.
+"""
+
+import argparse
+import json
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SRC = os.path.normpath(os.path.join(HERE, "..", "..", "src"))
+
+ARDUINO_H = """\
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+extern "C" {
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void noInterrupts(void);
+void interrupts(void);
+}
+"""
+
+# handler kinds; each adds one repeating timer to 'timerset'
+HANDLERS = {
+    # plain function returning HandlerResult
+    "function": """\
+static Timers::HandlerResult handler() { toggle(); return Timers::TimerStatus::repeat; }
+static void add() { timerset.every(500, handler); }
+""",
+    # lambda capturing a pointer (fits in std::function's small buffer)
+    "lambda": """\
+static int counter;
+static void add() { int* p = &counter; timerset.every(500, [p]() { ++*p; toggle(); return Timers::TimerStatus::repeat; }); }
+""",
+    # lambda capturing more state than fits in the small buffer
+    "large-capture": """\
+struct State { unsigned long a, b, c, d; };
+static State state;
+static void add() { State s = state; timerset.every(500, [s]() mutable { s.a += s.b + s.c + s.d; toggle(); return Timers::TimerStatus::repeat; }); }
+""",
+}
+
+# name: (defines, declaration of 'timerset', handler kind)
+CONFIGS = [
+    ("millis-4-function", [], "Timers::TimerSet<4, Timers::Clock::millis> timerset;", "function"),
+    ("millis-16-function", [], "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+    ("millis-64-function", [], "Timers::TimerSet<64, Timers::Clock::millis> timerset;", "function"),
+    ("micros-16-function", [], "Timers::TimerSet<16, Timers::Clock::micros> timerset;", "function"),
+    ("millis-16-lambda", [], "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "lambda"),
+    ("millis-16-large-capture", [], "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "large-capture"),
+    ("millis-16-freestanding", ["TIMERSET_FREESTANDING"],
+     "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "lambda"),
+    ("millis-16-extended", [],
+     "Timers::TimerSet<16, Timers::Clock::extended<Timers::Clock::millis>> timerset;", "function"),
+    ("millis-16-deadlines", ["TIMERSET_ABSOLUTE_DEADLINES"],
+     "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+    ("millis-16-shared", [],
+     "Timers::TimerSlotPool<16> pool;\nTimers::SharedTimerSet<> timerset(pool);", "function"),
+    ("millis-16-groups", ["TIMERSET_GROUPS=4"], "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+    ("millis-16-deferred", ["TIMERSET_DEFERRED_CALLS=8"],
+     "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+    ("millis-16-statistics", ["TIMERSET_STATISTICS"],
+     "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+    ("millis-16-touch", ["TIMERSET_TOUCH"], "Timers::TimerSet<16, Timers::Clock::millis> timerset;", "function"),
+]
+
+TARGETS = {
+    "cortex-m0": {
+        "cxx": "arm-none-eabi-g++",
+        "size": "arm-none-eabi-size",
+        "flags": ["-mcpu=cortex-m0plus", "-mthumb", "-fno-exceptions", "-fno-rtti",
+                  "-fno-threadsafe-statics"],
+    },
+    "host": {
+        "cxx": os.environ.get("CXX", "g++"),
+        "size": "size",
+        "flags": [],
+    },
+}
+
+COMMON_FLAGS = ["-std=gnu++17", "-Os", "-ffunction-sections", "-fdata-sections", "-c"]
+
+
+def source(config):
+    name, defines, declaration, handler = config
+    return ("".join("#define %s\n" % d.replace("=", " ", 1) for d in defines)
+            + "#include <arduino-timer-cpp17.hpp>\n"
+            + declaration + "\n"
+            + "extern void toggle();\n"
+            + HANDLERS[handler]
+            + "void setup() { add(); }\n"
+            + "void loop() { timerset.tick_and_delay(); }\n")
+
+
+def measure(target, config, workdir):
+    name = config[0]
+    cpp = os.path.join(workdir, name + ".cpp")
+    obj = os.path.join(workdir, "%s-%s.o" % (target, name))
+
+    with open(cpp, "w") as f:
+        f.write(source(config))
+
+    tools = TARGETS[target]
+    subprocess.run([tools["cxx"]] + COMMON_FLAGS + tools["flags"]
+                   + ["-I", workdir, "-I", SRC, cpp, "-o", obj], check=True)
+    output = subprocess.run([tools["size"], obj], check=True,
+                            capture_output=True, text=True).stdout
+
+    # berkeley format: text data bss dec hex filename
+    text, data, bss = (int(field) for field in output.splitlines()[1].split()[:3])
+    return text, data, bss
+
+
+def main():
+    parser = argparse.ArgumentParser(description="TimerSet footprint report")
+    parser.add_argument("--target", action="append", choices=sorted(TARGETS),
+                        help="target to build for (default: all available)")
+    parser.add_argument("--budget", default=os.path.join(HERE, "footprint-budget.json"))
+    parser.add_argument("--update", action="store_true",
+                        help="write the measured sizes as the new budgets")
+    parser.add_argument("--tolerance", type=float, default=2.0,
+                        help="allowed growth over budget, in percent")
+    parser.add_argument("--require-budgets", action="store_true",
+                        help="fail for configurations without a budget")
+    args = parser.parse_args()
+
+    targets = []
+    for target in args.target or sorted(TARGETS):
+        missing = [tool for tool in (TARGETS[target]["cxx"], TARGETS[target]["size"])
+                   if not shutil.which(tool)]
+        if missing:
+            print("WARNING: skipping target %s: %s not found" % (target, ", ".join(missing)),
+                  file=sys.stderr)
+        else:
+            targets.append(target)
+    if not targets:
+        sys.exit("no compiler available for the requested targets")
+
+    try:
+        with open(args.budget) as f:
+            budgets = json.load(f)
+    except FileNotFoundError:
+        budgets = {}
+
+    failed = []
+    unbudgeted = []
+    with tempfile.TemporaryDirectory() as workdir:
+        with open(os.path.join(workdir, "Arduino.h"), "w") as f:
+            f.write(ARDUINO_H)
+
+        for target in targets:
+            print("%-10s %-26s %7s %7s %7s %7s %7s" %
+                  ("target", "configuration", "text", "data", "bss", "total", "budget"))
+            for config in CONFIGS:
+                name = config[0]
+                text, data, bss = measure(target, config, workdir)
+                total = text + data + bss
+                budget = budgets.get(target, {}).get(name)
+                status = ""
+
+                if args.update:
+                    budgets.setdefault(target, {})[name] = total
+                elif budget is None:
+                    status = "  NO BUDGET"
+                    unbudgeted.append((target, name))
+                    if args.require_budgets:
+                        failed.append((target, name))
+                elif total > budget * (1 + args.tolerance / 100):
+                    status = "  OVER BUDGET"
+                    failed.append((target, name))
+
+                print("%-10s %-26s %7d %7d %7d %7d %7s%s" %
+                      (target, name, text, data, bss, total,
+                       "-" if budget is None else budget, status))
+            print()
+
+    if args.update:
+        with open(args.budget, "w") as f:
+            json.dump(budgets, f, indent=4, sort_keys=True)
+            f.write("\n")
+
+    for target in sorted(set(t for t, _ in unbudgeted)):
+        names = [n for t, n in unbudgeted if t == target]
+        if not budgets.get(target):
+            print("WARNING: target %s has no budgets in %s; its sizes can not fail the run "
+                  "(record them with --update)" % (target, os.path.basename(args.budget)),
+                  file=sys.stderr)
+        else:
+            print("WARNING: no budget for %s" % ", ".join("%s/%s" % (target, n) for n in names),
+                  file=sys.stderr)
+
+    if failed:
+        sys.exit("%d configuration(s) over budget or without one: %s" %
+                 (len(failed), ", ".join("%s/%s" % f for f in failed)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,88 @@
+#!/usr/bin/env python3
+"""
+Convert a TimerSet trace (written by TimerSet::dump_trace(), usually to
+the serial port) into Chrome trace event JSON, which can be loaded into
+Perfetto (https://ui.perfetto.dev) or chrome://tracing.
+
+usage: trace-to-chrome.py [input [output]]
+
+Reads from stdin / writes to stdout when files are not given. Lines
+which are not part of a trace dump are ignored, so a complete serial log
+can be used as input; each dump in the log becomes a separate process
+in the output.
+"""
+
+import json
+import sys
+
+STATUS = ["completed", "repeat", "reschedule"]
+
+
+def convert(lines):
+    events = []
+    dump = 0
+    tps = None
+    last = None
+    wraps = 0
+
+    for line in lines:
+        fields = line.split()
+
+        if line.startswith("# arduino-timer-cpp17 trace"):
+            dump += 1
+            tps = int(fields[-1])
+            last = None
+            wraps = 0
+            events.append({"ph": "M", "pid": dump, "name": "process_name",
+                           "args": {"name": "TimerSet dump %d" % dump}})
+            events.append({"ph": "M", "pid": dump, "tid": 0, "name": "thread_name",
+                           "args": {"name": "idle"}})
+            continue
+
+        if tps is None or len(fields) != 4 or not fields[0].isdigit():
+            if line.startswith("# end"):
+                tps = None
+            continue
+
+        time, kind, slot, value = int(fields[0]), fields[1], int(fields[2]), int(fields[3])
+
+        # timestamps are truncated to 32 bits; unwrap them
+        if last is not None and time < last:
+            wraps += 1 << 32
+        last = time
+
+        ts = (time + wraps) * 1e6 / tps
+        tid = slot + 1
+        common = {"pid": dump, "tid": tid, "ts": ts}
+
+        if kind == "begin":
+            events.append(dict(common, ph="B", name="timer %d" % slot,
+                               args={"lateness_us": value * 1e6 / tps}))
+        elif kind == "end":
+            status = STATUS[value] if value < len(STATUS) else str(value)
+            events.append(dict(common, ph="E", args={"status": status}))
+        elif kind == "idle" and value == 0xffffffff:
+            # no timers armed, waiting for an interrupt
+            events.append(dict(common, ph="i", tid=0, s="t", name="wait for interrupt"))
+        elif kind == "idle":
+            events.append(dict(common, ph="X", tid=0, name="idle", dur=value * 1e6 / tps))
+        elif kind in ("add", "reschedule"):
+            events.append(dict(common, ph="i", s="t", name=kind,
+                               args={"delay_us": value * 1e6 / tps}))
+        else:
+            events.append(dict(common, ph="i", s="t", name=kind))
+
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def main(argv):
+    source = open(argv[1]) if len(argv) > 1 else sys.stdin
+    target = open(argv[2], "w") if len(argv) > 2 else sys.stdout
+
+    with source, target:
+        json.dump(convert(source), target, indent=1)
+        target.write("\n")
+
+
+if __name__ == "__main__":
+    main(sys.argv)
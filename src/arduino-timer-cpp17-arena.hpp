@@ -0,0 +1,199 @@
+/**
+   arduino-timer - library for delaying function calls
+
+   Copyright (c) 2018, Michael Contreras
+   Copyright (c) 2020, Kevin P. Fleming
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+
+   1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+   TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+   PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+   TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Handlers whose captures are too large to be stored inline are kept in a
+// memory resource provided by the application instead of on the heap,
+// which is what std::function does with them. The resource is any object
+// with std::pmr::memory_resource's allocate(bytes, alignment) and
+// deallocate(pointer, bytes, alignment) members, such as a
+// std::pmr::unsynchronized_pool_resource (which reuses freed blocks) or a
+// std::pmr::monotonic_buffer_resource over a static buffer; it is given
+// as a template argument, so it must have static storage duration.
+
+#pragma once
+
+#include "arduino-timer-cpp17.hpp"
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace Timers {
+
+template <
+    typename T, // time type of the TimerSet's clock
+    auto* resource, // memory resource for large captures
+    size_t inline_size = 2 * sizeof(void*) // largest capture stored inline
+    >
+class ArenaHandler
+{
+    static_assert(inline_size >= sizeof(void*), "inline_size must hold at least a pointer");
+
+    using Result = BasicHandlerResult<T>;
+
+    // operations on a callable of one type, stored inline or in the
+    // resource (where storage holds a pointer to it)
+    struct Operations
+    {
+	Result (*invoke)(void* storage);
+	void (*move)(void* from, void* to) noexcept;
+	void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename F>
+    static constexpr bool stored_inline =
+	sizeof(F) <= inline_size && alignof(F) <= alignof(std::max_align_t) &&
+	std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    static F&
+    callable(void* storage) noexcept
+    {
+	if constexpr (stored_inline<F>) {
+	    return *std::launder(static_cast<F*>(storage));
+	} else {
+	    return **static_cast<F**>(storage);
+	}
+    }
+
+    template <typename F>
+    static constexpr Operations operations = {
+	[](void* storage) -> Result { return callable<F>(storage)(); },
+	[](void* from, void* to) noexcept {
+	    if constexpr (stored_inline<F>) {
+		::new (to) F(std::move(callable<F>(from)));
+		callable<F>(from).~F();
+	    } else {
+		// the callable stays where it is
+		::new (to) F*(*static_cast<F**>(from));
+	    }
+	},
+	[](void* storage) noexcept {
+	    F* f = &callable<F>(storage);
+
+	    f->~F();
+
+	    if constexpr (!stored_inline<F>) {
+		resource->deallocate(f, sizeof(F), alignof(F));
+	    }
+	}
+    };
+
+    alignas(std::max_align_t) unsigned char storage[inline_size];
+    const Operations* ops = nullptr;
+
+    void
+    reset() noexcept
+    {
+	if (ops) {
+	    ops->destroy(storage);
+	    ops = nullptr;
+	}
+    }
+
+public:
+    ArenaHandler() noexcept = default;
+
+    // callables which are too large (or not nothrow movable) are
+    // allocated from the resource
+    template <
+	typename F,
+	typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, ArenaHandler>>,
+	typename = decltype(Result(std::declval<std::decay_t<F>&>()()))
+	>
+    ArenaHandler(F&& f) : ops(&operations<std::decay_t<F>>)
+    {
+	using Callable = std::decay_t<F>;
+
+	if constexpr (stored_inline<Callable>) {
+	    ::new (static_cast<void*>(storage)) Callable(std::forward<F>(f));
+	} else {
+	    void* block = resource->allocate(sizeof(Callable), alignof(Callable));
+
+	    ::new (static_cast<void*>(storage)) Callable*(::new (block) Callable(std::forward<F>(f)));
+	}
+    }
+
+    ArenaHandler(ArenaHandler&& other) noexcept : ops(other.ops)
+    {
+	if (ops) {
+	    ops->move(other.storage, storage);
+	    other.ops = nullptr;
+	}
+    }
+
+    ArenaHandler&
+    operator=(ArenaHandler&& other) noexcept
+    {
+	if (this != &other) {
+	    reset();
+
+	    if (other.ops) {
+		other.ops->move(other.storage, storage);
+		ops = other.ops;
+		other.ops = nullptr;
+	    }
+	}
+
+	return *this;
+    }
+
+    ~ArenaHandler()
+    {
+	reset();
+    }
+
+    Result
+    operator()()
+    {
+	return ops->invoke(storage);
+    }
+
+    explicit operator bool() const noexcept
+    {
+	return ops != nullptr;
+    }
+};
+
+// TimerSet whose handlers keep large captures in *resource
+template <
+    auto* resource, // memory resource for large captures
+    size_t max_timers = TIMERSET_DEFAULT_TIMERS, // max number of timers
+    typename clock = Clock::millis // clock for timers
+    >
+using ArenaTimerSet = TimerSet<max_timers, clock, ArenaHandler<decltype(clock::now()), resource>>;
+
+}; // end namespace Timers
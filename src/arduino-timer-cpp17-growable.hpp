@@ -0,0 +1,258 @@
+/**
+   arduino-timer - library for delaying function calls
+
+   Copyright (c) 2018, Michael Contreras
+   Copyright (c) 2020, Kevin P. Fleming
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+
+   1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+   TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+   PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+   TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Growable timer slots for Linux (and other hosted) targets: a
+// GrowableTimerSet has no fixed number of timers, and allocates its slots
+// in chunks when all of its slots are in use. Chunks are never moved, so
+// TimerHandles stay valid while their timers exist; adding a chunk costs
+// O(chunk_timers), which is O(1) per timer slot.
+//
+// Empty chunks are kept for reuse, up to GrowthPolicy::spare_chunks of
+// them; others are freed at the end of the next tick(). A TimerHandle of a
+// removed timer must not be used once its chunk may have been freed (with
+// the default policy chunks are never freed).
+
+#pragma once
+
+#include "arduino-timer-cpp17.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace Timers {
+
+struct GrowthPolicy
+{
+    size_t chunk_timers = 16; // timer slots allocated at a time
+    size_t max_chunks = 0; // limit on the number of chunks (0 for none)
+    size_t spare_chunks = std::numeric_limits<size_t>::max(); // empty chunks kept
+};
+
+template <typename T, typename H>
+class TimerSlots<BasicTimer<T, H>, growable>
+{
+    using Timer = BasicTimer<T, H>;
+
+    GrowthPolicy policy;
+    std::vector<std::unique_ptr<Timer[]>> chunks; // nullptr where a chunk was freed
+    std::vector<size_t> live; // timers in use in each chunk
+    std::map<const Timer*, size_t> chunk_numbers; // first slot of each chunk
+    std::vector<size_t> free_slots; // indices of free slots, a stack (a new chunk's lowest on top)
+    size_t chunk_count = 0; // chunks allocated
+    size_t empty_count = 0; // allocated chunks with no timers in use
+
+    size_t
+    chunk_of(const Timer& timer) const noexcept
+    {
+	return std::prev(chunk_numbers.upper_bound(&timer))->second;
+    }
+
+    // Adds a chunk of free slots, in the first unused chunk number
+    // returns false if the chunk, or room to track it, can not be
+    // allocated; the containers are reserved up front (free_slots for
+    // every slot of every chunk), so release() never allocates
+    bool
+    grow() noexcept
+    {
+	if (policy.max_chunks && chunk_count == policy.max_chunks) {
+	    return false;
+	}
+
+	size_t chunk = std::find(chunks.begin(), chunks.end(), nullptr) - chunks.begin();
+
+#ifdef TIMERSET_GROUPS
+	// group links are 16-bit slot indices
+	if ((chunk + 1) * policy.chunk_timers >= 0xffff) {
+	    return false;
+	}
+#endif
+
+	std::unique_ptr<Timer[]> slots(new (std::nothrow) Timer[policy.chunk_timers]);
+
+	if (!slots) {
+	    return false;
+	}
+
+	try {
+	    chunks.reserve(chunk + 1);
+	    live.reserve(chunk + 1);
+	    free_slots.reserve((chunk_count + 1) * policy.chunk_timers);
+	    chunk_numbers.emplace(slots.get(), chunk);
+	} catch (const std::bad_alloc&) {
+	    return false;
+	}
+
+	if (chunk == chunks.size()) {
+	    chunks.emplace_back();
+	    live.push_back(0);
+	}
+
+	chunks[chunk] = std::move(slots);
+	++chunk_count;
+	++empty_count;
+
+	for (size_t i = policy.chunk_timers; i-- > 0; ) {
+	    free_slots.push_back(chunk * policy.chunk_timers + i);
+	}
+
+	return true;
+    }
+
+public:
+    // visits the slots of all allocated chunks in order; chunks added
+    // while iterating are not visited
+    class iterator
+    {
+	TimerSlots& slots;
+	size_t index;
+
+	void
+	skip() noexcept
+	{
+	    size_t chunk_timers = slots.policy.chunk_timers;
+
+	    while (index < slots.chunks.size() * chunk_timers && !slots.chunks[index / chunk_timers]) {
+		index += chunk_timers;
+	    }
+	}
+
+    public:
+	iterator(TimerSlots& slots, size_t index) noexcept : slots(slots), index(index)
+	{
+	    skip();
+	}
+
+	Timer& operator*() const noexcept { return slots[index]; }
+	iterator& operator++() noexcept { ++index; skip(); return *this; }
+	bool operator!=(const iterator& other) const noexcept { return index < other.index; }
+    };
+
+    TimerSlots() noexcept = default;
+
+    explicit TimerSlots(const GrowthPolicy& policy) noexcept : policy(policy)
+    {
+	if (this->policy.chunk_timers == 0) {
+	    this->policy.chunk_timers = 1;
+	}
+    }
+
+    iterator begin() noexcept { return iterator(*this, 0); }
+    iterator end() noexcept { return iterator(*this, chunks.size() * policy.chunk_timers); }
+
+    Timer&
+    operator[](size_t index) noexcept
+    {
+	return chunks[index / policy.chunk_timers][index % policy.chunk_timers];
+    }
+
+    size_t
+    index(const Timer& timer) const noexcept
+    {
+	size_t chunk = chunk_of(timer);
+
+	return chunk * policy.chunk_timers + (&timer - chunks[chunk].get());
+    }
+
+    // returns nullptr if a chunk is needed but can not be allocated
+    Timer*
+    allocate(size_t&) noexcept
+    {
+	if (free_slots.empty() && !grow()) {
+	    return nullptr;
+	}
+
+	size_t index = free_slots.back();
+
+	free_slots.pop_back();
+
+	if (live[index / policy.chunk_timers]++ == 0) {
+	    --empty_count;
+	}
+
+	return &(*this)[index];
+    }
+
+    void
+    release(Timer& timer) noexcept
+    {
+	size_t index = this->index(timer);
+
+	free_slots.push_back(index);
+
+	if (--live[index / policy.chunk_timers] == 0) {
+	    ++empty_count;
+	}
+    }
+
+    // Frees empty chunks beyond policy.spare_chunks
+    void
+    trim() noexcept
+    {
+	if (empty_count <= policy.spare_chunks) {
+	    return;
+	}
+
+	for (size_t chunk = chunks.size(); chunk-- > 0 && empty_count > policy.spare_chunks; ) {
+	    if (!chunks[chunk] || live[chunk]) {
+		continue;
+	    }
+
+	    free_slots.erase(std::remove_if(free_slots.begin(), free_slots.end(),
+					    [this, chunk](size_t index) {
+						return index / policy.chunk_timers == chunk;
+					    }),
+			     free_slots.end());
+	    chunk_numbers.erase(chunks[chunk].get());
+	    chunks[chunk].reset();
+	    --chunk_count;
+	    --empty_count;
+	}
+    }
+};
+
+// TimerSet without a fixed number of timers; pass a GrowthPolicy to the
+// constructor to change the chunk size or limits
+template <
+    typename clock = Clock::millis, // clock for timers
+    typename handler_type = BasicHandler<decltype(clock::now())> // handler type, as for TypedTimerSet
+    >
+using GrowableTimerSet = TimerSet<growable, clock, handler_type>;
+
+}; // end namespace Timers
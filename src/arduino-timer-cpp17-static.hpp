@@ -0,0 +1,149 @@
+/**
+   arduino-timer - library for delaying function calls
+
+   Copyright (c) 2018, Michael Contreras
+   Copyright (c) 2020, Kevin P. Fleming
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+
+   1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+   TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+   PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+   TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Static timer tables: for applications with a fixed set of periodic
+// tasks known at build time. The intervals and functions are template
+// arguments, so tick() is generated with the intervals folded into
+// constants and direct calls to the functions; nothing is registered at
+// startup, and the only data is the last start time of each task.
+
+#pragma once
+
+#include "arduino-timer-cpp17.hpp"
+
+namespace Timers {
+
+// A task in a StaticTimerSet: calls function every interval units of
+// time (which must not be 0)
+template <
+    Timepoint interval,
+    void (*function)()
+    >
+struct StaticTimer
+{
+};
+
+template <
+    typename clock,
+    typename... timers
+    >
+class StaticTimerSet;
+
+template <
+    typename clock, // clock for timers
+    Timepoint... intervals,
+    void (*... functions)()
+    >
+class StaticTimerSet<clock, StaticTimer<intervals, functions>...>
+{
+public:
+    using Timepoint = decltype(clock::now());
+
+private:
+    static constexpr size_t count = sizeof...(intervals);
+
+    static_assert(((intervals > 0) && ...), "interval must not be 0");
+
+    // start of the current interval of each task; all tasks start when
+    // the clock does (normally at power-up), unless restart() is called
+    detail::array<Timepoint, count> starts{};
+
+    template <
+	Timers::Timepoint interval,
+	void (*function)()
+	>
+    static
+    void
+    tick_timer(Timepoint& start) noexcept
+    {
+	Timepoint now = clock::now();
+
+	if (now - start >= interval) {
+	    function();
+	    start = now;
+	}
+    }
+
+    template <Timers::Timepoint interval>
+    static
+    void
+    next_timer(Timepoint start, Timepoint now, Timepoint& next_expiration) noexcept
+    {
+	Timepoint elapsed = now - start;
+	Timepoint remaining = elapsed < interval ? interval - elapsed : 0;
+	next_expiration = remaining < next_expiration ? remaining : next_expiration;
+    }
+
+    template <size_t... index>
+    Timepoint
+    tick(detail::index_sequence<index...>) noexcept
+    {
+	(tick_timer<intervals, functions>(starts[index]), ...);
+
+	// lowest remaining time after all tasks have run (which may have
+	// taken long enough for other tasks to be due)
+	Timepoint now = clock::now();
+	Timepoint next_expiration = detail::numeric_limits<Timepoint>::max();
+
+	(next_timer<intervals>(starts[index], now, next_expiration), ...);
+
+	return next_expiration;
+    }
+
+public:
+    // Restarts the interval of every task from now
+    void
+    restart() noexcept
+    {
+	starts.fill(clock::now());
+    }
+
+    // Ticks the timers forward - call this function in loop()
+    // returns Timepoint of next timer expiration
+    Timepoint
+    tick() noexcept
+    {
+	return tick(detail::make_index_sequence<count>());
+    }
+
+    // Ticks the timers forward, then delays until next timer is due
+    void
+    tick_and_delay() noexcept
+    {
+	clock::delay(tick());
+    }
+};
+
+}; // end namespace Timers
@@ -0,0 +1,250 @@
+/**
+   arduino-timer - library for delaying function calls
+
+   Copyright (c) 2018, Michael Contreras
+   Copyright (c) 2020, Kevin P. Fleming
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions are
+   met:
+
+   1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+   2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+   3. Neither the name of the copyright holder nor the names of its
+   contributors may be used to endorse or promote products derived from
+   this software without specific prior written permission.
+
+   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+   IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+   TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+   PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+   HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+   SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED
+   TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+// Worker pool for Linux (and other hosted) targets: TimerSet::tick(pool)
+// hands expired timers to the pool instead of running their handlers
+// inline, so a slow handler does not delay other timers. The handler
+// results are queued by the workers and applied to the TimerSet by the
+// next call to tick(pool), on the ticking thread. Several TimerSets may
+// share a pool: each job is tagged with the TimerSet which submitted it,
+// and each tick(pool) only applies the results of its own timers.
+//
+// Rules:
+//  - all TimerSet methods must be called from the ticking thread; handlers
+//    running on the pool must not call into their TimerSet
+//  - a timer is never dispatched again while its handler is running
+//  - when max_pending handlers are already queued or running, tick(pool)
+//    runs the handler of an expired timer on the ticking thread instead
+//  - the pool must outlive every TimerSet which dispatches to it
+
+#pragma once
+
+#include "arduino-timer-cpp17.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <ratio>
+#include <thread>
+
+namespace Timers {
+
+template <
+    size_t workers = 2, // number of worker threads
+    size_t max_pending = 2 * workers, // max number of handlers queued or running
+    typename time_type = Timepoint, // time type of the TimerSets' clock
+    typename handler_type = BasicHandler<time_type> // handler type of the TimerSets
+    >
+class WorkerPool
+{
+    using Timepoint = time_type;
+    using Timer = BasicTimer<Timepoint, handler_type>;
+
+    static_assert(workers > 0, "WorkerPool needs at least one worker");
+    static_assert(max_pending >= workers, "max_pending must be at least workers");
+
+    struct Job
+    {
+	const void* owner; // TimerSet which submitted the job
+	Timer* timer;
+	Timepoint dispatched;
+    };
+
+    struct Completion
+    {
+	const void* owner;
+	Timer* timer;
+	Timepoint dispatched;
+	TimerStatus status;
+	Timepoint next;
+    };
+
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable job_done;
+
+    std::array<Job, max_pending> jobs; // ring buffer
+    size_t job_head = 0;
+    size_t job_count = 0;
+
+    std::array<Completion, max_pending> completions;
+    size_t completion_count = 0;
+
+    size_t in_flight = 0; // submitted but not yet drained
+    std::array<const void*, max_pending> flight_owners{}; // nullptr: free
+    bool stopping = false;
+
+    std::array<std::thread, workers> threads;
+
+    void
+    run() noexcept
+    {
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+	    job_ready.wait(lock, [this](){ return stopping || job_count > 0; });
+
+	    if (stopping) {
+		return;
+	    }
+
+	    Job job = jobs[job_head];
+	    job_head = (job_head + 1) % max_pending;
+	    --job_count;
+
+	    lock.unlock();
+	    BasicHandlerResult<Timepoint> result = job.timer->handler();
+	    lock.lock();
+
+	    completions[completion_count++] = { job.owner, job.timer, job.dispatched, result.status, result.next };
+	    job_done.notify_all();
+	}
+    }
+
+public:
+    WorkerPool()
+    {
+	for (auto& thread: threads) {
+	    thread = std::thread([this](){ run(); });
+	}
+    }
+
+    // queued handlers are discarded; running handlers are allowed to finish
+    ~WorkerPool()
+    {
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+	    stopping = true;
+	}
+
+	job_ready.notify_all();
+
+	for (auto& thread: threads) {
+	    thread.join();
+	}
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Queues the handler of timer, which belongs to owner and expired at
+    // 'now'
+    // returns false if max_pending handlers are already queued or running
+    bool
+    submit(const void* owner, Timer& timer, Timepoint now) noexcept
+    {
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+
+	    if (in_flight == max_pending) {
+		return false;
+	    }
+
+	    jobs[(job_head + job_count) % max_pending] = { owner, &timer, now };
+	    ++job_count;
+	    ++in_flight;
+	    *std::find(flight_owners.begin(), flight_owners.end(), nullptr) = owner;
+	}
+
+	job_ready.notify_one();
+
+	return true;
+    }
+
+    // Passes the result of every handler of owner's timers which has
+    // finished since the last call to complete(timer, dispatched, result);
+    // results for other owners are kept for their own drain()
+    template <typename Complete>
+    void
+    drain(const void* owner, Complete&& complete) noexcept
+    {
+	std::array<Completion, max_pending> done;
+	size_t count = 0;
+
+	{
+	    std::lock_guard<std::mutex> lock(mutex);
+
+	    size_t kept = 0;
+
+	    for (size_t i = 0; i < completion_count; ++i) {
+		if (completions[i].owner == owner) {
+		    done[count++] = completions[i];
+		    *std::find(flight_owners.begin(), flight_owners.end(), owner) = nullptr;
+		} else {
+		    completions[kept++] = completions[i];
+		}
+	    }
+
+	    completion_count = kept;
+	    in_flight -= count;
+	}
+
+	for (size_t i = 0; i < count; ++i) {
+	    complete(*done[i].timer, done[i].dispatched, BasicHandlerResult<Timepoint>(done[i].status, done[i].next));
+	}
+    }
+
+    // Waits for ticks units of clock, or until a handler of owner's
+    // timers finishes; with no ticks, waits until one finishes (or for a
+    // millisecond, as wait_for_interrupt() does on hosts, if none of
+    // owner's handlers are queued or running)
+    template <typename clock>
+    void
+    wait(const void* owner, detail::optional<Timepoint> ticks) noexcept
+    {
+	using duration = std::chrono::duration<Timepoint, std::ratio<1, clock::ticks_per_second>>;
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	if (!ticks && std::find(flight_owners.begin(), flight_owners.end(), owner) == flight_owners.end()) {
+	    ticks = clock::ticks_per_second >= 1000 ? clock::ticks_per_second / 1000 : 1;
+	}
+
+	auto finished = [this, owner]() {
+	    return std::any_of(completions.begin(), completions.begin() + completion_count,
+			       [owner](const Completion& c){ return c.owner == owner; });
+	};
+
+	if (ticks) {
+	    job_done.wait_for(lock, duration(*ticks), finished);
+	} else {
+	    job_done.wait(lock, finished);
+	}
+    }
+};
+
+}; // end namespace Timers
@@ -40,306 +40,2630 @@
 #undef max
 #undef min
 
+// toolchains without the C++ standard library (such as the one for
+// MegaAVR-based boards) get minimal replacements for the parts of it
+// used here; define TIMERSET_FREESTANDING to use them with other
+// toolchains too (which produces smaller code)
+#if !defined(TIMERSET_FREESTANDING) && !__has_include(<functional>)
+#define TIMERSET_FREESTANDING 1
+#endif
+
+#ifdef TIMERSET_FREESTANDING
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#else
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <functional>
 #include <limits>
 #include <optional>
+#include <utility>
+#endif
+
+#if defined(__AVR__) && !defined(TIMERSET_WAIT_FOR_INTERRUPT)
+#include <avr/sleep.h>
+#endif
 
 #ifndef TIMERSET_DEFAULT_TIMERS
 #define TIMERSET_DEFAULT_TIMERS 0x10
 #endif
 
+// size of the storage for a handler (function object) in a freestanding
+// build; handlers which do not fit are rejected at compile time
+#if defined(TIMERSET_FREESTANDING) && !defined(TIMERSET_HANDLER_SIZE)
+#define TIMERSET_HANDLER_SIZE (2 * sizeof(void*))
+#endif
+
+// define TIMERSET_STATISTICS to collect lateness / handler duration
+// statistics for each timer and for each TimerSet; when it is not defined
+// none of the statistics code or data is compiled
+#if defined(TIMERSET_STATISTICS) && !defined(TIMERSET_STATISTICS_BUCKETS)
+#define TIMERSET_STATISTICS_BUCKETS 16
+#endif
+
+// define TIMERSET_TRACE to record timer events (add, remove, reschedule,
+// handler start / end, idle delays) of each TimerSet in a ring buffer of
+// the last TIMERSET_TRACE_EVENTS (a power of two) events; when it is not
+// defined none of the tracing code or data is compiled
+#if defined(TIMERSET_TRACE) && !defined(TIMERSET_TRACE_EVENTS)
+#define TIMERSET_TRACE_EVENTS 64
+#endif
+
+// define TIMERSET_TELEMETRY to have each TimerSet count live timers, peak
+// occupancy, failed inserts, and inserts per call site (for the first
+// TIMERSET_TELEMETRY_SITES distinct call sites)
+#if defined(TIMERSET_TELEMETRY) && !defined(TIMERSET_TELEMETRY_SITES)
+#define TIMERSET_TELEMETRY_SITES 16
+#endif
+
+// define TIMERSET_DEFERRED_CALLS to the capacity (a power of two, up to
+// 128) of a queue of calls which each TimerSet runs on its next tick(),
+// without using timer slots
+
+// define TIMERSET_ABSOLUTE_DEADLINES to have each timer store the clock
+// time at which it expires instead of its start time and delay: each
+// timer slot is one Timepoint smaller and the expiration tests are
+// cheaper, but delays must be shorter than half a wrap of the clock, and
+// repeating timers keep their phase (see README)
+
+// define TIMERSET_TOUCH to enable touch(), which postpones a timer
+// without requeueing it until its current expiration is reached; each
+// timer slot is then one Timepoint larger
+
+// define TIMERSET_GROUPS to the number of timer groups (1 - 255) in each
+// TimerSet to enable grouping of timers for bulk cancel / pause / resume /
+// shift; each timer then carries 5 bytes of group links
+
+// define TIMERSET_COROUTINES to enable the sleep_for / sleep_until
+// awaitables, which need C++20 (gnu++20) mode; each timer slot then holds
+// a coroutine handle
+#ifdef TIMERSET_COROUTINES
+#if !defined(__cpp_impl_coroutine) || !__has_include(<coroutine>)
+#error "TIMERSET_COROUTINES needs C++20 (gnu++20) mode"
+#endif
+#include <coroutine>
+#include <exception>
+#endif
+
+// std::chrono overloads and Clock::chrono are available when the
+// toolchain provides <chrono> (and the build is not freestanding)
+#if __has_include(<chrono>) && !defined(TIMERSET_NO_CHRONO) && !defined(TIMERSET_FREESTANDING)
+#include <chrono>
+#include <type_traits>
+#define TIMERSET_CHRONO 1
+#if __has_include(<thread>) && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+#include <thread>
+#define TIMERSET_CHRONO_SLEEP 1
+#endif
+#endif
+
 namespace Timers {
 
-using Timepoint = unsigned long;
+// The standard library types and functions used by the library: the
+// std versions in normal builds, and minimal versions with the same
+// interface in freestanding builds
+namespace detail {
 
-enum class TimerStatus
-    {
-     completed,
-     repeat,
-     reschedule
-    };
+#ifndef TIMERSET_FREESTANDING
+using std::array;
+using std::find_if;
+using std::function;
+using std::index_sequence;
+using std::is_same;
+using std::make_index_sequence;
+using std::move;
+using std::nullopt;
+using std::numeric_limits;
+using std::optional;
+using std::reference_wrapper;
+#else
+template <typename T> struct remove_reference { using type = T; };
+template <typename T> struct remove_reference<T&> { using type = T; };
+template <typename T> struct remove_reference<T&&> { using type = T; };
+
+template <typename T> struct remove_const { using type = T; };
+template <typename T> struct remove_const<const T> { using type = T; };
+
+template <typename T, typename U> struct is_same { static constexpr bool value = false; };
+template <typename T> struct is_same<T, T> { static constexpr bool value = true; };
 
-struct HandlerResult
+template <bool condition, typename T = void> struct enable_if {};
+template <typename T> struct enable_if<true, T> { using type = T; };
+
+template <typename T>
+constexpr typename remove_reference<T>::type&&
+move(T&& t) noexcept
 {
-    TimerStatus status;
-    Timepoint next;
+    return static_cast<typename remove_reference<T>::type&&>(t);
+}
 
-    // must be constructed with at least a status, but can be constructed
-    // with status and next
-    HandlerResult() = delete;
-    HandlerResult(TimerStatus status) : status(status) {}
-    HandlerResult(TimerStatus status, Timepoint next) : status(status), next(next) {}
-};
+template <typename T>
+T&& declval() noexcept;
+
+template <typename T>
+struct numeric_limits
+{
+    static_assert(T(~T(0)) > T(0), "only unsigned types are supported");
 
-using Handler = std::function<HandlerResult (void)>;
+    static constexpr T max() noexcept { return ~T(0); }
+};
 
-struct Timer
+template <typename T, size_t N>
+struct array
 {
-    Handler handler;
-    Timepoint start; // when timer was added (or repeat execution began)
-    Timepoint expires; // when the timer expires
-    Timepoint repeat; // default repeat interval
+    T elements[N];
 
-    // ensure that these objects will never be copied or moved
-    // (this could only happen by accident)
-    Timer() = default;
-    Timer(const Timer&) = delete;
-    Timer& operator=(const Timer&) = delete;
-    Timer(Timer&&) = delete;
-    Timer& operator=(Timer&&) = delete;
+    constexpr T& operator[](size_t i) noexcept { return elements[i]; }
+    constexpr const T& operator[](size_t i) const noexcept { return elements[i]; }
+    constexpr T* data() noexcept { return elements; }
+    constexpr const T* data() const noexcept { return elements; }
+    constexpr T* begin() noexcept { return elements; }
+    constexpr const T* begin() const noexcept { return elements; }
+    constexpr T* end() noexcept { return elements + N; }
+    constexpr const T* end() const noexcept { return elements + N; }
+    static constexpr size_t size() noexcept { return N; }
 
-    // boolean to indicate whether this timer is active
-    explicit operator bool() const noexcept
+    void
+    fill(const T& value) noexcept
     {
-	return static_cast<bool>(handler);
+	for (auto& element: elements) {
+	    element = value;
+	}
     }
 };
 
-using TimerHandle = std::optional<std::reference_wrapper<Timer>>;
-
-struct Clock
+template <typename Iterator, typename Predicate>
+Iterator
+find_if(Iterator first, Iterator last, Predicate p)
 {
-    struct millis
-    {
-	static
-	Timepoint now() noexcept
-	{
-	    return ::millis();
+    for (; first != last; ++first) {
+	if (p(*first)) {
+	    break;
 	}
+    }
 
-	static
-	void
-	delay(Timepoint until) noexcept
-	{
-	    ::delay(until);
-	}
-    };
+    return first;
+}
 
-    struct micros
-    {
-	static
-	Timepoint now() noexcept
-	{
-	    return ::micros();
-	}
+template <size_t... I> struct index_sequence {};
 
-	static
-	void delay(Timepoint until) noexcept
-	{
-	    unsigned int micros = until % 1000;
-	    until -= micros;
-	    until /= 1000;
+template <size_t N, size_t... I>
+struct make_index_sequence_helper : make_index_sequence_helper<N - 1, N - 1, I...> {};
 
-	    ::delayMicroseconds(micros);
-	    ::delay(until);
-	}
+template <size_t... I>
+struct make_index_sequence_helper<0, I...> { using type = index_sequence<I...>; };
+
+template <size_t N>
+using make_index_sequence = typename make_index_sequence_helper<N>::type;
+
+template <typename T>
+class reference_wrapper
+{
+    T* pointer;
+
+public:
+    reference_wrapper(T& t) noexcept : pointer(&t) {}
+
+    T& get() const noexcept { return *pointer; }
+    operator T&() const noexcept { return *pointer; }
+};
+
+struct nullopt_t
+{
+    explicit constexpr nullopt_t(int) {}
+};
+
+inline constexpr nullopt_t nullopt{0};
+
+// only for trivially copyable types
+template <typename T>
+class optional
+{
+    union
+    {
+	char empty;
+	T stored;
     };
+    bool engaged;
 
+public:
+    constexpr optional() noexcept : empty(), engaged(false) {}
+    constexpr optional(nullopt_t) noexcept : empty(), engaged(false) {}
+    constexpr optional(T value) noexcept : stored(value), engaged(true) {}
+
+    // like std::optional, construct from anything convertible to T
     template <
-	Timers::Timepoint (*clock_func)()
+	typename U,
+	typename = typename enable_if<
+	    !is_same<typename remove_const<typename remove_reference<U>::type>::type, optional>::value
+	    && !is_same<typename remove_const<typename remove_reference<U>::type>::type, T>::value
+	    >::type,
+	typename = decltype(T(declval<U&&>()))
 	>
-    struct custom
-    {
-	static
-	Timepoint now() noexcept
-	{
-	    return clock_func();
-	}
-    };
+    constexpr optional(U&& value) noexcept : stored(static_cast<U&&>(value)), engaged(true) {}
+
+    constexpr bool has_value() const noexcept { return engaged; }
+    constexpr explicit operator bool() const noexcept { return engaged; }
+    constexpr T& value() noexcept { return stored; }
+    constexpr const T& value() const noexcept { return stored; }
+    constexpr T& operator*() noexcept { return stored; }
+    constexpr const T& operator*() const noexcept { return stored; }
+    constexpr T* operator->() noexcept { return &stored; }
+    constexpr const T* operator->() const noexcept { return &stored; }
 };
 
-template <
-    size_t max_timers = TIMERSET_DEFAULT_TIMERS, // max number of timers
-    typename clock = Clock::millis // clock for timers
-    >
-class TimerSet
+template <typename Signature>
+class function;
+
+// Holds any trivially copyable function object (function pointers,
+// lambdas capturing pointers / references / numbers) of up to
+// TIMERSET_HANDLER_SIZE bytes, without allocating memory
+template <typename R, typename... Args>
+class function<R (Args...)>
 {
-    std::array<Timer, max_timers> timers;
+    alignas(void*) unsigned char storage[TIMERSET_HANDLER_SIZE];
+    R (*invoke)(const void*, Args...) = nullptr;
 
-    void
-    remove(TimerHandle handle) noexcept
+    template <typename F>
+    static
+    R
+    invoke_stored(const void* storage, Args... args)
     {
-	if (!handle) {
-	    return;
-	}
-
-	auto& timer = handle.value().get();
-
-	timer.handler = Handler();
-	timer.start = 0;
-	timer.expires = 0;
-	timer.repeat = 0;
+	return (*static_cast<F*>(const_cast<void*>(storage)))(args...);
     }
 
-    auto
-    next_timer_slot() noexcept
+public:
+    function() noexcept = default;
+    function(decltype(nullptr)) noexcept {}
+
+    template <
+	typename F,
+	typename = typename enable_if<!is_same<F, function>::value>::type,
+	typename = decltype(static_cast<R>(declval<F&>()(declval<Args>()...)))
+	>
+    function(F f) noexcept : invoke(invoke_stored<F>)
     {
-	return std::find_if(timers.begin(), timers.end(), [](Timer& t){ return !t; });
+	static_assert(sizeof(F) <= sizeof(storage), "handler is larger than TIMERSET_HANDLER_SIZE");
+	static_assert(alignof(F) <= alignof(void*), "handler alignment is not supported");
+	static_assert(__is_trivially_copyable(F), "handler must be trivially copyable");
+
+	memcpy(storage, &f, sizeof(F));
     }
 
-    TimerHandle
-    add_timer(Timepoint start, Timepoint expires, Handler&& h, Timepoint repeat = 0) noexcept
+    R operator()(Args... args) const { return invoke(storage, args...); }
+
+    explicit operator bool() const noexcept { return invoke != nullptr; }
+};
+#endif
+
+}; // end namespace detail
+
+using Timepoint = unsigned long;
+
+enum class TimerStatus
     {
-	if (auto it = next_timer_slot(); it != timers.end()) {
-	    it->handler = std::move(h);
-	    it->start = start;
-	    it->expires = expires;
-	    it->repeat = repeat;
+     completed,
+     repeat,
+     reschedule
+    };
 
-	    return TimerHandle(*it);
-	}
-	else {
-	    return TimerHandle();
-	}
-    }
+// Timer types are templates on the time type of the TimerSet's clock;
+// the Timepoint versions (HandlerResult, Handler, Timer, TimerHandle)
+// are used by all of the built-in clocks except Clock::extended
 
-    // Reschedules handler to be called in delay units of time
-    TimerHandle
-    reschedule_timer(TimerHandle handle, Timepoint start, Timepoint expires) noexcept
+template <typename T>
+struct BasicHandlerResult
+{
+    TimerStatus status;
+    T next;
+
+    // must be constructed with at least a status, but can be constructed
+    // with status and next
+    BasicHandlerResult() = delete;
+    BasicHandlerResult(TimerStatus status) : status(status), next(0) {}
+    BasicHandlerResult(TimerStatus status, T next) : status(status), next(next) {}
+
+    // handlers written for one time type can be used with another
+    template <typename U>
+    BasicHandlerResult(BasicHandlerResult<U> other) : status(other.status), next(other.next) {}
+};
+
+using HandlerResult = BasicHandlerResult<Timepoint>;
+
+template <typename T>
+using BasicHandler = detail::function<BasicHandlerResult<T> (void)>;
+
+using Handler = BasicHandler<Timepoint>;
+
+enum class TimerState : uint8_t
     {
-	if (!handle) {
-	    return handle;
-	}
+     idle, // slot is free
+     armed, // waiting for expiration
+     running, // handler is executing (inline or on a worker)
+     cancelled, // cancelled while running, remove when handler returns
+     paused // not waiting, the expiration holds the remaining time
+    };
 
-	auto& timer = handle.value().get();
+enum class TimerLimit : uint8_t
+    {
+     none, // repeats until completed or cancelled
+     count, // 'remaining' is the number of runs left
+     until // 'remaining' is the clock time of the last allowed run
+    };
 
-	if (!timer) {
-	    return handle;
-	}
+#ifdef TIMERSET_GROUPS
+static_assert(TIMERSET_GROUPS > 0 && TIMERSET_GROUPS < 256, "TIMERSET_GROUPS must be 1 - 255");
 
-	timer.start = start;
-	timer.expires = expires;
+// group numbers are 1 - TIMERSET_GROUPS; 0 means no group
+using TimerGroup = uint8_t;
+#endif
 
-	return handle;
-    }
+#ifdef TIMERSET_DEFERRED_CALLS
+// Disables interrupts while it exists, then restores their previous state
+// (instead of enabling them), so it can also be used where interrupts are
+// already disabled; on cores other than AVR and ARM Cortex-M the state
+// can not be read, and interrupts are enabled again
+class InterruptGuard
+{
+#if defined(__AVR__)
+    uint8_t sreg = SREG;
 
 public:
-    // Calls handler in delay units of time
-    TimerHandle
-    in(Timepoint delay, Handler&& h) noexcept
+    InterruptGuard() noexcept
     {
-	return add_timer(clock::now(), delay, std::move(h));
+	cli();
     }
 
-    // Calls handler at time
-    TimerHandle
-    at(Timepoint when, Handler&& h) noexcept
+    ~InterruptGuard()
     {
-	Timepoint now = clock::now();
-	return add_timer(now, when - now, std::move(h));
+	SREG = sreg;
     }
+#elif defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    uint32_t primask;
 
-    // Calls handler every interval units of time
-    TimerHandle
-    every(Timepoint interval, Handler&& h) noexcept
+public:
+    InterruptGuard() noexcept
     {
-	return add_timer(clock::now(), interval, std::move(h), interval);
+	__asm__ volatile ("mrs %0, primask\n\tcpsid i" : "=r" (primask) : : "memory");
     }
 
-    // Calls handler immediately and every interval units of time
-    TimerHandle
-    now_and_every(Timepoint interval, Handler&& h) noexcept
+    ~InterruptGuard()
     {
-	Timepoint now = clock::now();
-	return add_timer(now, now, std::move(h), interval);
+	__asm__ volatile ("msr primask, %0" : : "r" (primask) : "memory");
+    }
+#else
+public:
+    InterruptGuard() noexcept
+    {
+	noInterrupts();
     }
 
-    // Cancels timer
-    TimerHandle
-    cancel(TimerHandle handle) noexcept
+    ~InterruptGuard()
     {
-	if (!handle) {
-	    return handle;
-	}
+	interrupts();
+    }
+#endif
 
-	auto& timer = handle.value().get();
+    InterruptGuard(const InterruptGuard&) = delete;
+    InterruptGuard& operator=(const InterruptGuard&) = delete;
+};
 
-	if (!timer) {
-	    return handle;
-	}
+struct DeferredCall
+{
+    void (*function)(void*);
+    void* context;
+};
 
-	remove(timer);
+// FIFO of deferred calls; calls are added by TimerSet::defer() (with
+// interrupts disabled) or from interrupt handlers, and only removed by
+// run(), so single-byte indices (which are read and written atomically
+// on every board) are enough to keep it consistent without locking
+template <size_t calls>
+class DeferredQueue
+{
+    static_assert(calls > 0 && calls <= 128 && (calls & (calls - 1)) == 0,
+		  "deferred call capacity must be a power of two, up to 128");
 
-	return handle;
-    }
+    detail::array<DeferredCall, calls> ring;
+    volatile uint8_t head = 0; // next call to run
+    volatile uint8_t tail = 0; // next free entry
 
-    // Reschedules handler to be called in delay units of time
-    TimerHandle
-    reschedule_in(TimerHandle handle, Timepoint delay) noexcept
+public:
+    bool
+    push(DeferredCall call) noexcept
     {
-	return reschedule_timer(handle, clock::now(), delay);
+	uint8_t end = tail;
+
+	if (static_cast<uint8_t>(end - head) == calls) {
+	    return false;
+	}
+
+	ring[end & (calls - 1)] = call;
+	// the entry must be written before it is published
+	__atomic_signal_fence(__ATOMIC_RELEASE);
+	tail = end + 1;
+
+	return true;
     }
 
-    // Reschedules handler to be called at time
-    TimerHandle
-    reschedule_at(TimerHandle handle, Timepoint when) noexcept
+    bool
+    empty() const noexcept
     {
-	Timepoint now = clock::now();
-	return reschedule_timer(handle, now, when - now);
+	return head == tail;
     }
 
-    // Ticks the timerset forward - call this function in loop()
-    // returns Timepoint of next timer expiration */
-    Timepoint
-    tick() noexcept
+    // Runs the calls which were queued before run() was called; calls
+    // queued while they run are left for the next run()
+    void
+    run() noexcept
     {
-	Timepoint next_expiration = std::numeric_limits<Timepoint>::max();
+	uint8_t end = tail;
+	__atomic_signal_fence(__ATOMIC_ACQUIRE);
 
-	// execute handlers for any timers which have expired
-	for (auto& timer: timers) {
-	    if (!timer) {
-		continue;
-	    }
+	while (head != end) {
+	    DeferredCall call = ring[head & (calls - 1)];
+	    head = head + 1;
+	    call.function(call.context);
+	}
+    }
+};
+#endif
 
-	    Timepoint now = clock::now();
-	    Timepoint elapsed = now - timer.start;
+#ifdef TIMERSET_STATISTICS
+// Histogram of clock tick counts with power-of-two buckets: bucket 0
+// counts zero, bucket n counts values in [2^(n-1), 2^n), and the last
+// bucket also counts all larger values
+struct Histogram
+{
+    detail::array<uint32_t, TIMERSET_STATISTICS_BUCKETS> buckets{};
 
-	    if (elapsed >= timer.expires) {
-		auto [ status, next ] = timer.handler();
+    template <typename T>
+    void
+    record(T value) noexcept
+    {
+	size_t bucket = 0;
 
-		switch (status) {
-		case TimerStatus::completed:
-		    remove(timer);
-		    break;
-		case TimerStatus::repeat:
-		    if (timer.repeat > 0) {
-			timer.start = now;
-			timer.expires = timer.repeat;
-		    } else {
-			remove(timer);
-		    }
-		    break;
-		case TimerStatus::reschedule:
-		    timer.start = now;
-		    timer.expires = next;
-		    break;
-		}
-	    }
+	while (value != 0 && bucket < buckets.size() - 1) {
+	    value >>= 1;
+	    ++bucket;
 	}
 
-	// compute lowest remaining time after all handlers have been executed
-	// (some timers may have expired during handler execution)
-	Timepoint now = clock::now();
+	++buckets[bucket];
+    }
+};
 
-	for (auto& timer: timers) {
-	    if (!timer) {
-		continue;
-	    }
+struct TimerStatistics
+{
+    uint32_t fired = 0; // number of handler executions
+    uint32_t overruns = 0; // handlers which returned after their timer was due again
+    Histogram lateness; // clock ticks from expiration until dispatch
+    Histogram duration; // clock ticks from dispatch until the handler's result was applied
+};
+#endif
 
-	    Timepoint remaining = timer.expires - (now - timer.start);
-	    next_expiration = remaining < next_expiration ? remaining : next_expiration;
-	}
+// Source location of a call which adds a timer; methods which add timers
+// take one as a defaulted last argument, which is filled in with the
+// caller's location. Without TIMERSET_TELEMETRY it is empty and costs
+// nothing.
+#ifdef TIMERSET_TELEMETRY
+struct CallSite
+{
+    const char* file = nullptr;
+    uint_least32_t line = 0;
 
-	return next_expiration == std::numeric_limits<Timepoint>::max() ? 0 : next_expiration;
+    static constexpr
+    CallSite
+    current(const char* file = __builtin_FILE(), uint_least32_t line = __builtin_LINE()) noexcept
+    {
+	return { file, line };
     }
+};
 
-    // Ticks the timerset forward, then delays until next timer is due
-    void
-    tick_and_delay() noexcept
-    {
-	clock::delay(tick());
+struct CallSiteCount
+{
+    CallSite site; // file is nullptr for unused entries
+    uint32_t inserts = 0;
+    uint32_t failures = 0; // inserts which failed because the TimerSet was full
+};
+
+struct TimerSetTelemetry
+{
+    size_t live = 0; // timers currently in the TimerSet
+    size_t peak = 0; // highest value of live
+    uint32_t failures = 0; // inserts which failed because the TimerSet was full
+    uint32_t untracked = 0; // inserts from call sites which did not fit in sites
+    detail::array<CallSiteCount, TIMERSET_TELEMETRY_SITES> sites;
+
+    void
+    record_insert(CallSite site, bool added) noexcept
+    {
+	if (added) {
+	    peak = ++live > peak ? live : peak;
+	} else {
+	    ++failures;
+	}
+
+	for (auto& entry: sites) {
+	    if (!entry.site.file) {
+		entry.site = site;
+	    } else if (entry.site.file != site.file || entry.site.line != site.line) {
+		continue;
+	    }
+
+	    ++(added ? entry.inserts : entry.failures);
+	    return;
+	}
+
+	++untracked;
+    }
+};
+#else
+struct CallSite
+{
+    static constexpr CallSite current() noexcept { return {}; }
+};
+#endif
+
+#ifdef TIMERSET_TRACE
+enum class TraceEventType : uint8_t
+    {
+     add, // value is delay until expiration
+     remove,
+     reschedule, // value is delay until expiration
+     begin, // handler dispatched, value is lateness
+     end, // handler result applied, value is TimerStatus
+     idle // tick_and_delay() delay started, value is delay (or TraceEvent::forever)
+    };
+
+struct TraceEvent
+{
+    uint32_t time; // clock ticks, truncated to 32 bits
+    uint32_t value;
+    uint16_t slot; // index of the Timer in its TimerSet (pools have up to 65534)
+    TraceEventType type;
+
+    // idle event value when waiting for an interrupt (no timers armed)
+    static constexpr uint32_t forever = 0xffffffff;
+};
+
+// Ring buffer which keeps the last 'events' trace events; it is only
+// written by the thread which calls the TimerSet's methods, so it needs
+// no locking
+template <size_t events>
+class TraceBuffer
+{
+    static_assert(events > 0 && (events & (events - 1)) == 0, "events must be a power of two");
+
+    detail::array<TraceEvent, events> ring;
+    uint32_t recorded = 0; // total number of events ever recorded
+
+public:
+    void
+    record(uint32_t time, TraceEventType type, size_t slot, uint32_t value = 0) noexcept
+    {
+	ring[recorded++ & (events - 1)] = { time, value, static_cast<uint16_t>(slot), type };
+    }
+
+    // Writes the buffered events, oldest first, in the text format read
+    // by extras/tools/trace-to-chrome.py; out is usually Serial
+    template <typename Output>
+    void
+    dump(Output& out, uint32_t ticks_per_second) const
+    {
+	static const char* const names[] = { "add", "remove", "reschedule", "begin", "end", "idle" };
+
+	out.print("# arduino-timer-cpp17 trace ");
+	out.println(ticks_per_second);
+
+	for (uint32_t i = recorded > events ? recorded - events : 0; i != recorded; ++i) {
+	    const TraceEvent& event = ring[i & (events - 1)];
+
+	    out.print(event.time);
+	    out.print(' ');
+	    out.print(names[static_cast<uint8_t>(event.type)]);
+	    out.print(' ');
+	    out.print(static_cast<uint32_t>(event.slot));
+	    out.print(' ');
+	    out.println(event.value);
+	}
+
+	out.println("# end");
+    }
+
+    void
+    clear() noexcept
+    {
+	recorded = 0;
+    }
+};
+#endif
+
+// H is the type of the handler (BasicHandler<T>, unless the TimerSet
+// is a TypedTimerSet)
+template <typename T, typename H = BasicHandler<T>>
+struct BasicTimer
+{
+    H handler;
+#ifdef TIMERSET_ABSOLUTE_DEADLINES
+    T deadline; // when the timer expires (the time left, while paused)
+#else
+    T start; // when timer was added (or repeat execution began)
+    T expires; // when the timer expires
+#endif
+    T repeat; // default repeat interval
+    T remaining; // see TimerLimit
+#ifdef TIMERSET_TOUCH
+    T postponed; // added to the expiration by touch(), once it is reached
+#endif
+    TimerState state = TimerState::idle;
+    TimerLimit limit = TimerLimit::none;
+#ifdef TIMERSET_COROUTINES
+    std::coroutine_handle<> waiter; // coroutine to resume instead of handler
+#endif
+#ifdef TIMERSET_STATISTICS
+    TimerStatistics statistics; // since the timer was added
+#endif
+#ifdef TIMERSET_GROUPS
+    // intrusive list of the timers in a group, linked by slot index + 1
+    // (0 for none)
+    uint16_t group_prev = 0;
+    uint16_t group_next = 0;
+    TimerGroup group = 0;
+#endif
+
+    // ensure that these objects will never be copied or moved
+    // (this could only happen by accident)
+    BasicTimer() = default;
+    BasicTimer(const BasicTimer&) = delete;
+    BasicTimer& operator=(const BasicTimer&) = delete;
+    BasicTimer(BasicTimer&&) = delete;
+    BasicTimer& operator=(BasicTimer&&) = delete;
+
+    // boolean to indicate whether this timer is active
+    explicit operator bool() const noexcept
+    {
+	return state != TimerState::idle;
+    }
+};
+
+using Timer = BasicTimer<Timepoint>;
+
+// Description of a timer for TimerSet::add(): the handler is called after
+// delay, then every repeat (if it is not 0) units of time
+template <typename T, typename H = BasicHandler<T>>
+struct BasicTimerSpec
+{
+    T delay;
+    H handler;
+    T repeat = 0;
+#ifdef TIMERSET_GROUPS
+    TimerGroup group = 0; // group to join (0: none)
+#endif
+};
+
+using TimerSpec = BasicTimerSpec<Timepoint>;
+
+template <typename T, typename H = BasicHandler<T>>
+using BasicTimerHandle = detail::optional<detail::reference_wrapper<BasicTimer<T, H>>>;
+
+using TimerHandle = BasicTimerHandle<Timepoint>;
+
+#ifdef TIMERSET_COROUTINES
+// Minimal fire-and-forget coroutine type for functions which co_await
+// TimerSet::sleep_for() / sleep_until(); the coroutine starts running
+// immediately and its frame is freed when it returns
+struct Task
+{
+    struct promise_type
+    {
+	Task get_return_object() noexcept { return {}; }
+	std::suspend_never initial_suspend() noexcept { return {}; }
+	std::suspend_never final_suspend() noexcept { return {}; }
+	void return_void() noexcept {}
+	void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+#endif
+
+struct Clock
+{
+    struct millis
+    {
+	static constexpr Timepoint ticks_per_second = 1000;
+
+	static
+	Timepoint now() noexcept
+	{
+	    return ::millis();
+	}
+
+	static
+	void
+	delay(Timepoint until) noexcept
+	{
+	    ::delay(until);
+	}
+    };
+
+    struct micros
+    {
+	static constexpr Timepoint ticks_per_second = 1000000;
+
+	using coarse = millis; // see extended
+
+	static
+	Timepoint now() noexcept
+	{
+	    return ::micros();
+	}
+
+	static
+	void delay(Timepoint until) noexcept
+	{
+	    unsigned int micros = until % 1000;
+	    until -= micros;
+	    until /= 1000;
+
+	    ::delayMicroseconds(micros);
+	    ::delay(until);
+	}
+    };
+
+    template <
+	Timers::Timepoint (*clock_func)(),
+	Timers::Timepoint ticks = 1000 // clock_func units per second
+	>
+    struct custom
+    {
+	static constexpr Timepoint ticks_per_second = ticks;
+
+	static
+	Timepoint now() noexcept
+	{
+	    return clock_func();
+	}
+    };
+
+    // Slower clock counting the same time as C, whose counter wraps far
+    // less often (C::coarse, such as millis for micros); void if none
+    template <typename C> static auto coarse_clock(int) -> typename C::coarse;
+    template <typename C> static void coarse_clock(long);
+
+    // Extends the counter of another clock (32 bits wide on most boards)
+    // to a 64-bit monotonic timeline, so that delays are no longer limited
+    // to one wrap period of the counter (~49.7 days for millis, ~71.6
+    // minutes for micros). Wraps are counted by now(). With a coarse
+    // clock (millis, for micros) the wraps missed between two calls are
+    // recovered from the time it has counted since, so now() need only be
+    // called once per wrap of the coarse clock (~49.7 days); otherwise it
+    // must be called at least once per wrap period of the base clock.
+    // in(), at(), tick() and tick_and_delay() all call it, and
+    // applications which may not call any of them for that long can call
+    // poll().
+    template <
+	typename base,
+	unsigned int counter_bits = 8 * sizeof(decltype(base::now())), // width of base counter
+	typename coarse = decltype(coarse_clock<base>(0)) // clock to recover missed wraps from
+	>
+    struct extended
+    {
+	static_assert(counter_bits <= 64, "counter must not be wider than 64 bits");
+
+	static constexpr uint64_t counter_max = counter_bits == 64 ? ~uint64_t(0) : (uint64_t(1) << counter_bits) - 1;
+
+	static constexpr Timepoint ticks_per_second = base::ticks_per_second;
+
+	static
+	uint64_t now() noexcept
+	{
+	    if constexpr (counter_bits == 64) {
+		return base::now();
+	    } else if constexpr (detail::is_same<coarse, void>::value) {
+		static uint64_t last = 0;
+		static uint64_t wraps = 0;
+
+		uint64_t low = base::now() & counter_max;
+
+		if (low < last) {
+		    wraps += counter_max + 1;
+		}
+		last = low;
+
+		return wraps + low;
+	    } else {
+		static_assert(base::ticks_per_second % coarse::ticks_per_second == 0,
+			      "base clock must count a whole number of ticks per coarse clock tick");
+
+		static uint64_t last = 0;
+		static decltype(coarse::now()) last_coarse = 0;
+
+		decltype(coarse::now()) coarse_now = coarse::now();
+		uint64_t low = base::now() & counter_max;
+
+		// the time counted by the coarse clock since the last call
+		// locates the base counter to well within half a wrap, and
+		// the low bits then give the exact time
+		uint64_t estimate = last + uint64_t(decltype(coarse::now())(coarse_now - last_coarse))
+		    * (base::ticks_per_second / coarse::ticks_per_second);
+		uint64_t time = (estimate & ~counter_max) | low;
+
+		if (time + counter_max / 2 < estimate) {
+		    time += counter_max + 1;
+		} else if (time > estimate + counter_max / 2) {
+		    time -= counter_max + 1;
+		}
+
+		last = time;
+		last_coarse = coarse_now;
+
+		return time;
+	    }
+	}
+
+	static
+	void
+	poll() noexcept
+	{
+	    now();
+	}
+
+	// base::delay() can only wait for part of a wrap period, and the
+	// wrap must be observed, so long delays are split into chunks
+	static
+	void
+	delay(uint64_t until) noexcept
+	{
+	    constexpr uint64_t chunk = counter_max / 2;
+
+	    while (until > chunk) {
+		base::delay(chunk);
+		until -= chunk;
+		now();
+	    }
+
+	    base::delay(until);
+	}
+    };
+
+#ifdef TIMERSET_CHRONO
+    // Adapts any std::chrono clock (such as std::chrono::steady_clock on
+    // Linux); time is counted in ticks of the clock's period, and
+    // TimerSets using it also accept time_points of the clock
+    template <typename C>
+    struct chrono
+    {
+	static_assert(C::period::num == 1, "clock period must be a fraction of a second");
+
+	using chrono_clock = C;
+
+	static constexpr uint64_t ticks_per_second = C::period::den;
+
+	static
+	std::make_unsigned_t<typename C::rep> now() noexcept
+	{
+	    return C::now().time_since_epoch().count();
+	}
+
+	static
+	void
+	delay(std::make_unsigned_t<typename C::rep> until) noexcept
+	{
+#ifdef TIMERSET_CHRONO_SLEEP
+	    std::this_thread::sleep_for(typename C::duration(until));
+#else
+	    auto end = C::now() + typename C::duration(until);
+	    while (C::now() < end) {}
+#endif
+	}
+    };
+#endif
+};
+
+// Waits for the next interrupt (which may add a timer or queue a deferred
+// call); used by tick_and_delay() when no timers are armed. The Arduino
+// cores' periodic tick interrupt ends the wait within a millisecond.
+// Define TIMERSET_WAIT_FOR_INTERRUPT to the name of a function to use
+// instead.
+template <typename clock>
+void
+wait_for_interrupt() noexcept
+{
+#if defined(TIMERSET_WAIT_FOR_INTERRUPT)
+    TIMERSET_WAIT_FOR_INTERRUPT();
+#elif defined(__ARM_ARCH_PROFILE) && __ARM_ARCH_PROFILE == 'M'
+    __asm__ volatile ("wfi");
+#elif defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_mode();
+#else
+    // no interrupts to wait for on hosts; poll every millisecond
+    clock::delay(clock::ticks_per_second >= 1000 ? clock::ticks_per_second / 1000 : 1);
+#endif
+}
+
+// max_timers of a GrowableTimerSet, whose slots are allocated as needed
+// (see arduino-timer-cpp17-growable.hpp)
+constexpr size_t growable = ~size_t(0);
+
+// Timer slots shared by several SharedTimerSets, so that memory is sized
+// for their combined peak number of timers rather than the sum of their
+// peaks. Free slots are kept in a list, so taking and returning a slot
+// is O(1); each slot records the TimerSet which owns it (0 if free).
+template <typename T, typename H = BasicHandler<T>>
+class BasicTimerSlotPool
+{
+public:
+    using Timer = BasicTimer<T, H>;
+
+private:
+    Timer* slots = nullptr;
+    uint16_t* links = nullptr; // next free slot index + 1 (0 for none)
+    uint8_t* owners = nullptr;
+    uint16_t count = 0;
+    uint16_t free_head = 0; // first free slot index + 1 (0 for none)
+    uint8_t owner_ids[32] = {}; // bit set for each owner in use
+
+protected:
+    BasicTimerSlotPool() noexcept = default;
+
+    // Called by the derived class with its storage, puts all slots in the
+    // free list
+    void
+    init(Timer* slots, uint16_t* links, uint8_t* owners, uint16_t count) noexcept
+    {
+	this->slots = slots;
+	this->links = links;
+	this->owners = owners;
+	this->count = count;
+
+	for (uint16_t i = 0; i < count; ++i) {
+	    links[i] = i + 1 < count ? i + 2 : 0;
+	    owners[i] = 0;
+	}
+
+	free_head = count > 0 ? 1 : 0;
+    }
+
+public:
+    BasicTimerSlotPool(const BasicTimerSlotPool&) = delete;
+    BasicTimerSlotPool& operator=(const BasicTimerSlotPool&) = delete;
+
+    // Identifies a new owner (1 - 255)
+    // returns 0 if 255 owners already share the pool
+    uint8_t
+    add_owner() noexcept
+    {
+	for (unsigned int id = 1; id < 256; ++id) {
+	    if (!(owner_ids[id / 8] & (1 << id % 8))) {
+		owner_ids[id / 8] |= 1 << id % 8;
+		return id;
+	    }
+	}
+
+	return 0;
+    }
+
+    // Frees the slots still taken by owner, destroying their handlers (and
+    // the coroutines sleeping in them), and its identifier
+    void
+    remove_owner(uint8_t owner) noexcept
+    {
+	if (!owner) {
+	    return;
+	}
+
+	for (uint16_t index = 0; index < count; ++index) {
+	    if (owners[index] != owner) {
+		continue;
+	    }
+
+	    Timer& timer = slots[index];
+
+	    timer.handler = H();
+	    timer.state = TimerState::idle;
+	    timer.limit = TimerLimit::none;
+#ifdef TIMERSET_COROUTINES
+	    if (timer.waiter) {
+		timer.waiter.destroy();
+		timer.waiter = nullptr;
+	    }
+#endif
+#ifdef TIMERSET_GROUPS
+	    timer.group_prev = 0;
+	    timer.group_next = 0;
+	    timer.group = 0;
+#endif
+	    release(timer);
+	}
+
+	owner_ids[owner / 8] &= ~(1 << owner % 8);
+    }
+
+    // Takes a free slot for owner
+    // returns nullptr if all slots are in use (or owner is 0)
+    Timer*
+    allocate(uint8_t owner) noexcept
+    {
+	if (!free_head || !owner) {
+	    return nullptr;
+	}
+
+	uint16_t index = free_head - 1;
+
+	free_head = links[index];
+	owners[index] = owner;
+
+	return &slots[index];
+    }
+
+    // Returns the slot of timer (which must be idle) to the free list
+    void
+    release(Timer& timer) noexcept
+    {
+	uint16_t index = &timer - slots;
+
+	owners[index] = 0;
+	links[index] = free_head;
+	free_head = index + 1;
+    }
+
+    Timer* data() noexcept { return slots; }
+    uint16_t size() const noexcept { return count; }
+    uint8_t owner(uint16_t index) const noexcept { return owners[index]; }
+};
+
+template <
+    size_t slots, // number of timer slots
+    typename clock = Clock::millis, // clock of the TimerSets
+    typename handler_type = BasicHandler<decltype(clock::now())> // handler type of the TimerSets
+    >
+class TimerSlotPool : public BasicTimerSlotPool<decltype(clock::now()), handler_type>
+{
+    static_assert(slots > 0 && slots < 0xffff, "a pool must have 1 - 65534 slots");
+
+    using Base = BasicTimerSlotPool<decltype(clock::now()), handler_type>;
+
+    detail::array<typename Base::Timer, slots> timers;
+    detail::array<uint16_t, slots> links;
+    detail::array<uint8_t, slots> owners;
+
+public:
+    TimerSlotPool() noexcept
+    {
+	Base::init(timers.data(), links.data(), owners.data(), slots);
+    }
+};
+
+// The timer slots of a TimerSet: an array of its own, searched for a free
+// slot when a timer is added
+template <typename Timer, size_t slots>
+class TimerSlots
+{
+    detail::array<Timer, slots> timers;
+
+public:
+    Timer* begin() noexcept { return timers.begin(); }
+    Timer* end() noexcept { return timers.end(); }
+    Timer& operator[](size_t index) noexcept { return timers[index]; }
+    size_t index(const Timer& timer) const noexcept { return &timer - timers.data(); }
+
+    // finds the first free slot at or after index cursor, and moves the
+    // cursor past it, so that a batch of timers is added in one pass
+    Timer*
+    allocate(size_t& cursor) noexcept
+    {
+	auto it = detail::find_if(timers.begin() + cursor, timers.end(), [](Timer& t){ return !t; });
+
+	if (it == timers.end()) {
+	    cursor = slots;
+	    return nullptr;
+	}
+
+	cursor = it - timers.begin() + 1;
+	return it;
+    }
+
+    void release(Timer&) noexcept {}
+
+    // called at the end of each tick, when no slots are being iterated
+    void trim() noexcept {}
+};
+
+// The timer slots of a SharedTimerSet (a TimerSet with 0 timers of its
+// own): the slots of a BasicTimerSlotPool which it owns
+template <typename T, typename H>
+class TimerSlots<BasicTimer<T, H>, 0>
+{
+    using Timer = BasicTimer<T, H>;
+    using Pool = BasicTimerSlotPool<T, H>;
+
+    Pool& pool;
+    uint8_t owner;
+
+public:
+    // visits the owned slots of the pool in order; slots taken or
+    // returned while iterating are visited or skipped accordingly
+    class iterator
+    {
+	Pool& pool;
+	uint8_t owner;
+	uint16_t index;
+
+	void
+	skip() noexcept
+	{
+	    while (index < pool.size() && pool.owner(index) != owner) {
+		++index;
+	    }
+	}
+
+    public:
+	iterator(Pool& pool, uint8_t owner, uint16_t index) noexcept
+	    : pool(pool), owner(owner), index(index)
+	{
+	    skip();
+	}
+
+	Timer& operator*() const noexcept { return pool.data()[index]; }
+	iterator& operator++() noexcept { ++index; skip(); return *this; }
+	bool operator!=(const iterator& other) const noexcept { return index != other.index; }
+    };
+
+    // a TimerSet beyond the 255th sharing the pool gets owner 0, so it
+    // can not add timers
+    explicit TimerSlots(Pool& pool) noexcept : pool(pool), owner(pool.add_owner()) {}
+
+    // returns the slots still in use to the pool
+    ~TimerSlots()
+    {
+	pool.remove_owner(owner);
+    }
+
+    TimerSlots(const TimerSlots&) = delete;
+    TimerSlots& operator=(const TimerSlots&) = delete;
+
+    iterator begin() noexcept { return iterator(pool, owner, owner ? 0 : pool.size()); }
+    iterator end() noexcept { return iterator(pool, owner, pool.size()); }
+    Timer& operator[](size_t index) noexcept { return pool.data()[index]; }
+    size_t index(const Timer& timer) const noexcept { return &timer - pool.data(); }
+
+    Timer* allocate(size_t&) noexcept { return pool.allocate(owner); }
+    void release(Timer& timer) noexcept { pool.release(timer); }
+    void trim() noexcept {}
+};
+
+template <
+    size_t max_timers = TIMERSET_DEFAULT_TIMERS, // max number of timers (0: see SharedTimerSet)
+    typename clock = Clock::millis, // clock for timers
+    typename handler_type = BasicHandler<decltype(clock::now())> // see TypedTimerSet
+    >
+class TimerSet
+{
+public:
+    using clock_type = clock;
+
+    // time type of the clock (64 bits for Clock::extended, Timers::Timepoint
+    // otherwise) and the timer types using it
+    using Timepoint = decltype(clock::now());
+    using HandlerResult = BasicHandlerResult<Timepoint>;
+    using Handler = handler_type;
+    using Timer = BasicTimer<Timepoint, Handler>;
+    using TimerHandle = BasicTimerHandle<Timepoint, Handler>;
+    using TimerSpec = BasicTimerSpec<Timepoint, Handler>;
+
+#ifdef TIMERSET_CHRONO
+    // std::chrono duration of one clock tick
+    using Duration = std::chrono::duration<Timepoint, std::ratio<1, clock::ticks_per_second>>;
+#endif
+
+    TimerSet() noexcept = default;
+
+    // TimerSet whose slots are configured by argument: the TimerSlotPool of
+    // a SharedTimerSet (which must outlive it), or the GrowthPolicy of a
+    // GrowableTimerSet
+    template <typename Argument>
+    explicit TimerSet(Argument&& argument) noexcept : timers(argument) {}
+
+private:
+    TimerSlots<Timer, max_timers> timers;
+
+    // armed timer which expires first (nullptr if there are none), kept up
+    // to date as timers change; recomputed by next_expiration() when a
+    // change may have made it expire later
+    Timer* earliest = nullptr;
+    bool earliest_known = true;
+
+    // whether tick_timers() is running, and the time its tick began
+    bool ticking = false;
+    Timepoint tick_begin = 0;
+
+#ifdef TIMERSET_DEFERRED_CALLS
+    DeferredQueue<TIMERSET_DEFERRED_CALLS> deferred;
+
+    static
+    void
+    call_function(void* function) noexcept
+    {
+	reinterpret_cast<void (*)()>(function)();
+    }
+#endif
+
+    // Whether clock time 'when' has been reached at 'now'; wraparound-
+    // correct while they are less than half a wrap of the clock apart
+    static constexpr
+    bool
+    reached(Timepoint when, Timepoint now) noexcept
+    {
+	return Timepoint(now - when) <= detail::numeric_limits<Timepoint>::max() / 2;
+    }
+
+#ifdef TIMERSET_ABSOLUTE_DEADLINES
+    // Arms timer to expire delay units of time after start
+    static
+    void
+    schedule(Timer& timer, Timepoint start, Timepoint delay) noexcept
+    {
+	timer.deadline = start + delay;
+    }
+
+    // Moves the expiration of timer delta units of time later
+    static
+    void
+    postpone(Timer& timer, Timepoint delta) noexcept
+    {
+	timer.deadline += delta;
+    }
+
+    // Clock time at which timer expires
+    static
+    Timepoint
+    expiration(const Timer& timer) noexcept
+    {
+	return timer.deadline;
+    }
+
+    // Time left until timer expires, postponed by extra (0 if it is due)
+    static
+    Timepoint
+    remaining_time(const Timer& timer, Timepoint now, Timepoint extra = 0) noexcept
+    {
+	Timepoint deadline = timer.deadline + extra;
+	return reached(deadline, now) ? 0 : deadline - now;
+    }
+
+    // Time since a due timer expired
+    static
+    Timepoint
+    lateness(const Timer& timer, Timepoint now) noexcept
+    {
+	return now - timer.deadline;
+    }
+
+    // Whether timer had expired when the tick which began at 'begin' did
+    // (timers armed during the tick expire after 'begin', see arm())
+    static
+    bool
+    expired_before(const Timer& timer, Timepoint now, Timepoint begin) noexcept
+    {
+	(void) now;
+	return reached(timer.deadline, begin);
+    }
+#else
+    // Arms timer to expire delay units of time after start
+    static
+    void
+    schedule(Timer& timer, Timepoint start, Timepoint delay) noexcept
+    {
+	timer.start = start;
+	timer.expires = delay;
+    }
+
+    // Moves the expiration of timer delta units of time later
+    static
+    void
+    postpone(Timer& timer, Timepoint delta) noexcept
+    {
+	timer.expires += delta;
+    }
+
+    // Clock time at which timer expires
+    static
+    Timepoint
+    expiration(const Timer& timer) noexcept
+    {
+	return timer.start + timer.expires;
+    }
+
+    // Time left until timer expires, postponed by extra (0 if it is due),
+    // wraparound-correct
+    static
+    Timepoint
+    remaining_time(const Timer& timer, Timepoint now, Timepoint extra = 0) noexcept
+    {
+	Timepoint elapsed = now - timer.start;
+	Timepoint expires = timer.expires + extra;
+	return elapsed < expires ? expires - elapsed : 0;
+    }
+
+    // Time since a due timer expired
+    static
+    Timepoint
+    lateness(const Timer& timer, Timepoint now) noexcept
+    {
+	return (now - timer.start) - timer.expires;
+    }
+
+    // Whether timer was started no later than the tick which began at
+    // 'begin', and had expired by then (timers armed during the tick
+    // expire after 'begin', see arm())
+    static
+    bool
+    expired_before(const Timer& timer, Timepoint now, Timepoint begin) noexcept
+    {
+	Timepoint elapsed = now - timer.start;
+	Timepoint tick_elapsed = now - begin;
+
+	return elapsed >= tick_elapsed && elapsed - tick_elapsed >= timer.expires;
+    }
+#endif
+
+    // Time added to the expiration of timer by touch()
+    static
+    Timepoint
+    postponement(const Timer& timer) noexcept
+    {
+#ifdef TIMERSET_TOUCH
+	return timer.postponed;
+#else
+	(void) timer;
+	return 0;
+#endif
+    }
+
+    // Arms timer to expire delay units of time after start. A timer armed
+    // during a tick which would count as expired when the tick began
+    // (with no delay while the clock still reads that time, or with
+    // absolute deadlines, a deadline at or before it, as from at() with a
+    // time in the past) expires a unit of time after the tick began
+    // instead, so that it is left for a later tick.
+    void
+    arm(Timer& timer, Timepoint start, Timepoint delay) noexcept
+    {
+#ifdef TIMERSET_ABSOLUTE_DEADLINES
+	if (ticking && reached(start + delay, tick_begin)) {
+	    start = tick_begin;
+	    delay = 1;
+	}
+#else
+	if (ticking && delay == 0 && start == tick_begin) {
+	    delay = 1;
+	}
+#endif
+
+	schedule(timer, start, delay);
+    }
+
+    // Updates 'earliest' after timer was added, removed, rescheduled,
+    // paused, resumed or dispatched
+    void
+    changed(Timer& timer, Timepoint now) noexcept
+    {
+	if (earliest == &timer) {
+	    earliest_known = false;
+	} else if (earliest_known && timer.state == TimerState::armed &&
+		   (!earliest || remaining_time(timer, now) < remaining_time(*earliest, now))) {
+	    earliest = &timer;
+	}
+    }
+
+#ifdef TIMERSET_STATISTICS
+    TimerStatistics totals;
+#endif
+
+#ifdef TIMERSET_TELEMETRY
+    TimerSetTelemetry counters;
+#endif
+
+#ifdef TIMERSET_GROUPS
+    static_assert(max_timers < 0xffff || max_timers == growable, "too many timers for group links");
+
+    // first timer in each group, as slot index + 1 (0 for none)
+    detail::array<uint16_t, TIMERSET_GROUPS> group_heads{};
+
+    void
+    unlink(Timer& timer) noexcept
+    {
+	if (!timer.group) {
+	    return;
+	}
+
+	if (timer.group_prev) {
+	    timers[timer.group_prev - 1].group_next = timer.group_next;
+	} else {
+	    group_heads[timer.group - 1] = timer.group_next;
+	}
+
+	if (timer.group_next) {
+	    timers[timer.group_next - 1].group_prev = timer.group_prev;
+	}
+
+	timer.group = 0;
+	timer.group_prev = 0;
+	timer.group_next = 0;
+    }
+
+    void
+    link(Timer& timer, TimerGroup group) noexcept
+    {
+	uint16_t index = timers.index(timer) + 1;
+	uint16_t& head = group_heads[group - 1];
+
+	timer.group = group;
+	timer.group_prev = 0;
+	timer.group_next = head;
+
+	if (head) {
+	    timers[head - 1].group_prev = index;
+	}
+
+	head = index;
+    }
+
+    // Calls f for each timer in group; f may remove the timer
+    template <typename F>
+    void
+    for_each_in_group(TimerGroup group, F&& f) noexcept
+    {
+	if (group == 0 || group > TIMERSET_GROUPS) {
+	    return;
+	}
+
+	for (uint16_t index = group_heads[group - 1]; index;) {
+	    Timer& timer = timers[index - 1];
+	    index = timer.group_next;
+	    f(timer);
+	}
+    }
+#endif
+
+#ifdef TIMERSET_TRACE
+    TraceBuffer<TIMERSET_TRACE_EVENTS> tracebuffer;
+
+    void
+    trace(TraceEventType type, const Timer& timer, uint32_t value = 0) noexcept
+    {
+	tracebuffer.record(clock::now(), type, timers.index(timer), value);
+    }
+#endif
+
+#ifdef TIMERSET_CHRONO
+    // Converts a std::chrono duration to clock ticks, rounding up so that
+    // timers never expire early; the conversion factor is a compile-time
+    // constant (and no conversion at all when the units match)
+    template <typename Rep, typename Period>
+    static constexpr Timepoint
+    ticks(std::chrono::duration<Rep, Period> d) noexcept
+    {
+	return std::chrono::ceil<Duration>(d).count();
+    }
+
+    // Converts a time_point of the clock (only Clock::chrono) to clock ticks
+    template <typename C, typename D>
+    static constexpr Timepoint
+    ticks(std::chrono::time_point<C, D> t) noexcept
+    {
+	static_assert(std::is_same_v<C, typename clock::chrono_clock>,
+		      "time_point must be from the TimerSet's clock");
+	return ticks(t.time_since_epoch());
+    }
+#endif
+
+    void
+    remove(TimerHandle handle) noexcept
+    {
+	if (!handle) {
+	    return;
+	}
+
+	auto& timer = handle.value().get();
+
+#ifdef TIMERSET_TRACE
+	trace(TraceEventType::remove, timer);
+#endif
+#ifdef TIMERSET_TELEMETRY
+	--counters.live;
+#endif
+#ifdef TIMERSET_GROUPS
+	unlink(timer);
+#endif
+
+	timer.handler = Handler();
+	schedule(timer, 0, 0);
+	timer.repeat = 0;
+	timer.remaining = 0;
+#ifdef TIMERSET_TOUCH
+	timer.postponed = 0;
+#endif
+	timer.state = TimerState::idle;
+	timer.limit = TimerLimit::none;
+	changed(timer, 0);
+#ifdef TIMERSET_COROUTINES
+	timer.waiter = nullptr;
+#endif
+	timers.release(timer);
+    }
+
+    TimerHandle
+    add_timer(Timepoint start, Timepoint expires, Handler&& h, Timepoint repeat, CallSite site) noexcept
+    {
+	size_t cursor = 0;
+
+	return add_timer(cursor, start, expires, detail::move(h), repeat, site);
+    }
+
+    // As above, taking the first free slot from cursor on (see TimerSlots)
+    TimerHandle
+    add_timer(size_t& cursor, Timepoint start, Timepoint expires, Handler&& h, Timepoint repeat, CallSite site) noexcept
+    {
+	Timer* it = timers.allocate(cursor);
+
+#ifdef TIMERSET_TELEMETRY
+	counters.record_insert(site, it != nullptr);
+#else
+	(void) site;
+#endif
+
+	if (it) {
+	    it->handler = detail::move(h);
+	    arm(*it, start, expires);
+	    it->repeat = repeat;
+	    it->remaining = 0;
+#ifdef TIMERSET_TOUCH
+	    it->postponed = 0;
+#endif
+	    it->state = TimerState::armed;
+	    it->limit = TimerLimit::none;
+#ifdef TIMERSET_STATISTICS
+	    it->statistics = TimerStatistics();
+#endif
+#ifdef TIMERSET_TRACE
+	    trace(TraceEventType::add, *it, expires);
+#endif
+	    changed(*it, start);
+
+	    return TimerHandle(*it);
+	}
+	else {
+	    return TimerHandle();
+	}
+    }
+
+    // Reschedules handler to be called in delay units of time
+    TimerHandle
+    reschedule_timer(TimerHandle handle, Timepoint start, Timepoint expires) noexcept
+    {
+	if (!handle) {
+	    return handle;
+	}
+
+	auto& timer = handle.value().get();
+
+	if (!timer) {
+	    return handle;
+	}
+
+	// a paused timer stays paused, with expires as its time left
+	if (timer.state == TimerState::paused) {
+	    schedule(timer, 0, expires);
+	} else {
+	    arm(timer, start, expires);
+	}
+#ifdef TIMERSET_TOUCH
+	timer.postponed = 0;
+#endif
+	changed(timer, start);
+
+#ifdef TIMERSET_TRACE
+	trace(TraceEventType::reschedule, timer, expires);
+#endif
+
+	return handle;
+    }
+
+    // Stops an armed timer, keeping the time remaining until expiration
+    void
+    pause_timer(Timer& timer, Timepoint now) noexcept
+    {
+	if (timer.state != TimerState::armed) {
+	    return;
+	}
+
+	schedule(timer, 0, remaining_time(timer, now, postponement(timer)));
+#ifdef TIMERSET_TOUCH
+	timer.postponed = 0;
+#endif
+	timer.state = TimerState::paused;
+	changed(timer, now);
+    }
+
+    // Restarts a paused timer with its remaining time
+    void
+    resume_timer(Timer& timer, Timepoint now) noexcept
+    {
+	if (timer.state != TimerState::paused) {
+	    return;
+	}
+
+	// while paused, the expiration is the time left
+	arm(timer, now, expiration(timer));
+	timer.state = TimerState::armed;
+	changed(timer, now);
+    }
+
+    TimerHandle
+    limit_timer(TimerHandle handle, TimerLimit limit, Timepoint remaining) noexcept
+    {
+	if (handle) {
+	    auto& timer = handle.value().get();
+	    timer.limit = limit;
+	    timer.remaining = remaining;
+	}
+
+	return handle;
+    }
+
+    // Applies the result of a handler which was started at 'now'
+    void
+    complete(Timer& timer, Timepoint now, HandlerResult result) noexcept
+    {
+#ifdef TIMERSET_STATISTICS
+	Timepoint duration = clock::now() - now;
+	++timer.statistics.fired;
+	timer.statistics.duration.record(duration);
+	++totals.fired;
+	totals.duration.record(duration);
+#endif
+#ifdef TIMERSET_TRACE
+	trace(TraceEventType::end, timer, static_cast<uint32_t>(result.status));
+#endif
+
+	if (timer.state == TimerState::cancelled) {
+	    remove(timer);
+	    return;
+	}
+
+	timer.state = TimerState::armed;
+
+	switch (result.status) {
+	case TimerStatus::completed:
+	    remove(timer);
+	    break;
+	case TimerStatus::repeat:
+	    if (timer.repeat > 0) {
+#ifdef TIMERSET_ABSOLUTE_DEADLINES
+		// keep the phase, unless a whole interval was missed
+		postpone(timer, timer.repeat);
+		if (reached(timer.deadline, now)) {
+		    schedule(timer, now, timer.repeat);
+		}
+#else
+		schedule(timer, now, timer.repeat);
+#endif
+	    } else {
+		remove(timer);
+	    }
+	    break;
+	case TimerStatus::reschedule:
+	    arm(timer, now, result.next);
+	    break;
+	}
+
+	if (timer.state == TimerState::armed) {
+	    switch (timer.limit) {
+	    case TimerLimit::none:
+		break;
+	    case TimerLimit::count:
+		if (--timer.remaining == 0) {
+		    remove(timer);
+		}
+		break;
+	    case TimerLimit::until:
+		if (!reached(expiration(timer), timer.remaining)) {
+		    remove(timer);
+		}
+		break;
+	    }
+	}
+
+	if (timer.state == TimerState::armed) {
+	    // not 'now', which may be long past when a worker pool ran
+	    // the handler, and would be before the start of timers added
+	    // since (making them look due)
+	    changed(timer, clock::now());
+	}
+
+#ifdef TIMERSET_STATISTICS
+	if (timer && remaining_time(timer, clock::now()) == 0) {
+	    ++timer.statistics.overruns;
+	    ++totals.overruns;
+	}
+#endif
+    }
+
+    // Passes each timer which had expired when the tick began to dispatch,
+    // which must either complete it or mark it as running (and report that
+    // with changed()); timers added or rescheduled during the tick (by
+    // handlers, or when they repeat) have started since then, so they are
+    // left for the next tick, which bounds the work of a tick to one
+    // handler call per timer
+    // returns time until next timer expiration, empty if no timers are armed
+    template <typename Dispatch>
+    detail::optional<Timepoint>
+    tick_timers(Dispatch&& dispatch) noexcept
+    {
+#ifdef TIMERSET_DEFERRED_CALLS
+	deferred.run();
+#endif
+
+	Timepoint begin = clock::now();
+
+	ticking = true;
+	tick_begin = begin;
+
+	// dispatch handlers for any timers which had expired at 'begin'
+	for (auto& timer: timers) {
+	    if (timer.state != TimerState::armed) {
+		continue;
+	    }
+
+	    Timepoint now = clock::now();
+
+	    if (expired_before(timer, now, begin)) {
+#ifdef TIMERSET_TOUCH
+		if (timer.postponed) {
+		    // touched since it was scheduled: requeue it with the
+		    // postponed expiration, which may also have passed
+		    postpone(timer, timer.postponed);
+		    timer.postponed = 0;
+		    changed(timer, now);
+#ifdef TIMERSET_TRACE
+		    trace(TraceEventType::reschedule, timer, remaining_time(timer, now));
+#endif
+
+		    if (!expired_before(timer, now, begin)) {
+			continue;
+		    }
+		}
+#endif
+
+#ifdef TIMERSET_STATISTICS
+		timer.statistics.lateness.record(lateness(timer, now));
+		totals.lateness.record(lateness(timer, now));
+#endif
+#ifdef TIMERSET_TRACE
+		trace(TraceEventType::begin, timer, lateness(timer, now));
+#endif
+#ifdef TIMERSET_COROUTINES
+		if (timer.waiter) {
+		    // free the slot first, so the coroutine can sleep again
+		    auto waiter = timer.waiter;
+		    remove(timer);
+		    waiter.resume();
+#ifdef TIMERSET_STATISTICS
+		    ++totals.fired;
+		    totals.duration.record(clock::now() - now);
+#endif
+#ifdef TIMERSET_TRACE
+		    trace(TraceEventType::end, timer, static_cast<uint32_t>(TimerStatus::completed));
+#endif
+		    continue;
+		}
+#endif
+		dispatch(timer, now);
+	    }
+	}
+
+	ticking = false;
+	timers.trim();
+
+	// lowest remaining time after all handlers have been executed
+	// (some timers may have expired during handler execution)
+	return next_expiration();
+    }
+
+public:
+#ifdef TIMERSET_COROUTINES
+    // Awaitable returned by sleep_for() / sleep_until(); co_await yields
+    // false (without suspending) if the TimerSet is full
+    class Sleep
+    {
+	TimerSet& timerset;
+	Timepoint start;
+	Timepoint expires;
+	CallSite site;
+	bool armed = false;
+
+    public:
+	Sleep(TimerSet& timerset, Timepoint start, Timepoint expires, CallSite site) noexcept
+	    : timerset(timerset), start(start), expires(expires), site(site) {}
+
+	bool await_ready() const noexcept { return false; }
+
+	bool
+	await_suspend(std::coroutine_handle<> waiter) noexcept
+	{
+	    if (auto handle = timerset.add_timer(start, expires, Handler(), 0, site)) {
+		handle.value().get().waiter = waiter;
+		armed = true;
+	    }
+
+	    return armed;
+	}
+
+	bool await_resume() const noexcept { return armed; }
+    };
+
+    // Suspends the calling coroutine for delay units of time; tick()
+    // resumes it directly
+    Sleep
+    sleep_for(Timepoint delay, CallSite site = CallSite::current()) noexcept
+    {
+	return Sleep(*this, clock::now(), delay, site);
+    }
+
+    // Suspends the calling coroutine until time
+    Sleep
+    sleep_until(Timepoint when, CallSite site = CallSite::current()) noexcept
+    {
+	Timepoint now = clock::now();
+	return Sleep(*this, now, when - now, site);
+    }
+#endif
+
+    // Calls handler in delay units of time
+    TimerHandle
+    in(Timepoint delay, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return add_timer(clock::now(), delay, detail::move(h), 0, site);
+    }
+
+    // Calls handler at time
+    TimerHandle
+    at(Timepoint when, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	Timepoint now = clock::now();
+	return add_timer(now, when - now, detail::move(h), 0, site);
+    }
+
+    // Calls handler every interval units of time
+    TimerHandle
+    every(Timepoint interval, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return add_timer(clock::now(), interval, detail::move(h), interval, site);
+    }
+
+    // Calls handler every interval units of time, count times; returns
+    // an empty TimerHandle if count is 0
+    TimerHandle
+    every(Timepoint interval, Timepoint count, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	if (count == 0) {
+	    return TimerHandle();
+	}
+
+	return limit_timer(add_timer(clock::now(), interval, detail::move(h), interval, site),
+			   TimerLimit::count, count);
+    }
+
+    // Calls handler every interval units of time, as long as the call is
+    // due no later than deadline (a clock time less than half a wrap of
+    // the clock away); returns an empty TimerHandle if the first call
+    // would be after deadline
+    TimerHandle
+    every_until(Timepoint interval, Timepoint deadline, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	Timepoint now = clock::now();
+
+	if (interval > deadline - now) {
+	    return TimerHandle();
+	}
+
+	return limit_timer(add_timer(now, interval, detail::move(h), interval, site),
+			   TimerLimit::until, deadline);
+    }
+
+    // Calls handler immediately and every interval units of time
+    TimerHandle
+    now_and_every(Timepoint interval, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return add_timer(clock::now(), 0, detail::move(h), interval, site);
+    }
+
+    // Adds a timer for each TimerSpec ({ delay, handler, repeat, group }) in specs,
+    // which can be any range (such as an array); all of the delays are
+    // relative to a single reading of the clock, and the free slots are
+    // claimed in one pass. The handlers are moved out of the specs. If
+    // handles is not nullptr, the handle of each timer is stored in it.
+    // returns the number of timers added (all of them, or those before the
+    // first which did not fit)
+    template <typename Specs>
+    size_t
+    add(Specs& specs, TimerHandle* handles = nullptr, CallSite site = CallSite::current()) noexcept
+    {
+	Timepoint now = clock::now();
+	size_t cursor = 0;
+	size_t added = 0;
+
+	for (auto& spec: specs) {
+	    auto handle = add_timer(cursor, now, spec.delay, detail::move(spec.handler), spec.repeat, site);
+
+	    if (!handle) {
+		break;
+	    }
+
+#ifdef TIMERSET_GROUPS
+	    if (spec.group) {
+		join(handle, spec.group);
+	    }
+#endif
+
+	    if (handles) {
+		handles[added] = handle;
+	    }
+
+	    ++added;
+	}
+
+	return added;
+    }
+
+    // Cancels timer
+    TimerHandle
+    cancel(TimerHandle handle) noexcept
+    {
+	if (!handle) {
+	    return handle;
+	}
+
+	auto& timer = handle.value().get();
+
+	if (!timer) {
+	    return handle;
+	}
+
+	// a running handler still owns its slot; it will be removed
+	// when the handler returns
+	if (timer.state == TimerState::running) {
+	    timer.state = TimerState::cancelled;
+	} else {
+	    remove(timer);
+	}
+
+	return handle;
+    }
+
+    // Reschedules handler to be called in delay units of time (a paused
+    // timer stays paused, and expires delay units of time after it is
+    // resumed)
+    TimerHandle
+    reschedule_in(TimerHandle handle, Timepoint delay) noexcept
+    {
+	return reschedule_timer(handle, clock::now(), delay);
+    }
+
+#ifdef TIMERSET_TOUCH
+    // Postpones timer to expire in delay units of time, like
+    // reschedule_in(), but only records the new expiration: when the
+    // current one is reached the timer is requeued instead of fired, so
+    // refreshing a timeout (e.g. on every received byte) is a single store
+    // (a delay expiring earlier than the current expiration, or a timer
+    // which is due or not armed, is rescheduled as by reschedule_in())
+    TimerHandle
+    touch(TimerHandle handle, Timepoint delay) noexcept
+    {
+	if (!handle) {
+	    return handle;
+	}
+
+	auto& timer = handle.value().get();
+
+	Timepoint left = timer.state == TimerState::armed ? remaining_time(timer, clock::now()) : 0;
+
+	if (delay < left || left == 0) {
+	    return reschedule_in(handle, delay);
+	}
+
+	timer.postponed = delay - left;
+
+	return handle;
+    }
+#endif
+
+    // Reschedules handler to be called at time
+    TimerHandle
+    reschedule_at(TimerHandle handle, Timepoint when) noexcept
+    {
+	Timepoint now = clock::now();
+	return reschedule_timer(handle, now, when - now);
+    }
+
+    // Pauses timer, keeping the time remaining until it expires; paused
+    // timers are ignored by tick() until resumed (a timer whose handler is
+    // running cannot be paused)
+    TimerHandle
+    pause(TimerHandle handle) noexcept
+    {
+	if (handle) {
+	    pause_timer(handle.value().get(), clock::now());
+	}
+
+	return handle;
+    }
+
+    // Resumes a paused timer with its remaining time
+    TimerHandle
+    resume(TimerHandle handle) noexcept
+    {
+	if (handle) {
+	    resume_timer(handle.value().get(), clock::now());
+	}
+
+	return handle;
+    }
+
+#ifdef TIMERSET_CHRONO
+    // std::chrono versions of the methods above; durations are converted
+    // to the units of the TimerSet's clock, and time_points must be from
+    // the clock (TimerSets using Clock::chrono only)
+    template <typename Rep, typename Period>
+    TimerHandle
+    in(std::chrono::duration<Rep, Period> delay, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return in(ticks(delay), detail::move(h), site);
+    }
+
+    template <typename C, typename D>
+    TimerHandle
+    at(std::chrono::time_point<C, D> when, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return at(ticks(when), detail::move(h), site);
+    }
+
+    template <typename Rep, typename Period>
+    TimerHandle
+    every(std::chrono::duration<Rep, Period> interval, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return every(ticks(interval), detail::move(h), site);
+    }
+
+    template <typename Rep, typename Period>
+    TimerHandle
+    every(std::chrono::duration<Rep, Period> interval, Timepoint count, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return every(ticks(interval), count, detail::move(h), site);
+    }
+
+    template <typename Rep, typename Period, typename C, typename D>
+    TimerHandle
+    every_until(std::chrono::duration<Rep, Period> interval, std::chrono::time_point<C, D> deadline, Handler&& h,
+		CallSite site = CallSite::current()) noexcept
+    {
+	return every_until(ticks(interval), ticks(deadline), detail::move(h), site);
+    }
+
+    template <typename Rep, typename Period>
+    TimerHandle
+    now_and_every(std::chrono::duration<Rep, Period> interval, Handler&& h, CallSite site = CallSite::current()) noexcept
+    {
+	return now_and_every(ticks(interval), detail::move(h), site);
+    }
+
+    template <typename Rep, typename Period>
+    TimerHandle
+    reschedule_in(TimerHandle handle, std::chrono::duration<Rep, Period> delay) noexcept
+    {
+	return reschedule_in(handle, ticks(delay));
+    }
+
+#ifdef TIMERSET_TOUCH
+    template <typename Rep, typename Period>
+    TimerHandle
+    touch(TimerHandle handle, std::chrono::duration<Rep, Period> delay) noexcept
+    {
+	return touch(handle, ticks(delay));
+    }
+#endif
+
+    template <typename C, typename D>
+    TimerHandle
+    reschedule_at(TimerHandle handle, std::chrono::time_point<C, D> when) noexcept
+    {
+	return reschedule_at(handle, ticks(when));
+    }
+
+#ifdef TIMERSET_COROUTINES
+    template <typename Rep, typename Period>
+    Sleep
+    sleep_for(std::chrono::duration<Rep, Period> delay, CallSite site = CallSite::current()) noexcept
+    {
+	return sleep_for(ticks(delay), site);
+    }
+
+    template <typename C, typename D>
+    Sleep
+    sleep_until(std::chrono::time_point<C, D> when, CallSite site = CallSite::current()) noexcept
+    {
+	return sleep_until(ticks(when), site);
+    }
+#endif
+#endif
+
+#ifdef TIMERSET_STATISTICS
+    // Statistics for all timers since the TimerSet was created (or
+    // reset_statistics() was called)
+    const TimerStatistics&
+    statistics() const noexcept
+    {
+	return totals;
+    }
+
+    // Statistics for one timer since it was added
+    // returns nullptr if the handle is not valid
+    const TimerStatistics*
+    statistics(TimerHandle handle) const noexcept
+    {
+	if (!handle || !handle.value().get()) {
+	    return nullptr;
+	}
+
+	return &handle.value().get().statistics;
+    }
+
+    void
+    reset_statistics() noexcept
+    {
+	totals = TimerStatistics();
+
+	for (auto& timer: timers) {
+	    timer.statistics = TimerStatistics();
+	}
+    }
+#endif
+
+#ifdef TIMERSET_GROUPS
+    // Adds timer to group (1 - TIMERSET_GROUPS), or removes it from its
+    // group if group is 0; a timer can be in one group at a time
+    TimerHandle
+    join(TimerHandle handle, TimerGroup group) noexcept
+    {
+	if (!handle || group > TIMERSET_GROUPS) {
+	    return handle;
+	}
+
+	auto& timer = handle.value().get();
+
+	if (!timer) {
+	    return handle;
+	}
+
+	unlink(timer);
+
+	if (group) {
+	    link(timer, group);
+	}
+
+	return handle;
+    }
+
+    // Cancels all timers in group
+    void
+    cancel_group(TimerGroup group) noexcept
+    {
+	for_each_in_group(group, [this](Timer& timer) { cancel(timer); });
+    }
+
+    // Pauses all timers in group, keeping their remaining time; timers
+    // whose handlers are running are not paused
+    void
+    pause_group(TimerGroup group) noexcept
+    {
+	Timepoint now = clock::now();
+	for_each_in_group(group, [this, now](Timer& timer) { pause_timer(timer, now); });
+    }
+
+    // Resumes all paused timers in group with their remaining time
+    void
+    resume_group(TimerGroup group) noexcept
+    {
+	Timepoint now = clock::now();
+	for_each_in_group(group, [this, now](Timer& timer) { resume_timer(timer, now); });
+    }
+
+    // Postpones all timers in group by delta units of time
+    void
+    shift_group(TimerGroup group, Timepoint delta) noexcept
+    {
+	Timepoint now = clock::now();
+	for_each_in_group(group, [this, now, delta](Timer& timer) {
+				     postpone(timer, delta);
+				     changed(timer, now);
+				 });
+    }
+#endif
+
+#ifdef TIMERSET_TELEMETRY
+    // Occupancy counters of the TimerSet
+    const TimerSetTelemetry&
+    telemetry() const noexcept
+    {
+	return counters;
+    }
+
+    // Restarts peak occupancy from the current number of timers, and
+    // clears the failure and call site counters
+    void
+    reset_telemetry() noexcept
+    {
+	TimerSetTelemetry fresh;
+	fresh.live = fresh.peak = counters.live;
+	counters = fresh;
+    }
+#endif
+
+#ifdef TIMERSET_TRACE
+    // Writes the trace buffer (oldest event first) to out, usually Serial,
+    // for conversion by extras/tools/trace-to-chrome.py
+    template <typename Output>
+    void
+    dump_trace(Output& out) const
+    {
+	tracebuffer.dump(out, clock::ticks_per_second);
+    }
+
+    void
+    clear_trace() noexcept
+    {
+	tracebuffer.clear();
+    }
+#endif
+
+#ifdef TIMERSET_DEFERRED_CALLS
+    // Queues function(context) to be called by the next tick(), before
+    // any timer handlers, without using a timer slot
+    // returns false if the queue is full
+    bool
+    defer(void (*function)(void*), void* context = nullptr) noexcept
+    {
+	InterruptGuard guard;
+
+	return deferred.push({ function, context });
+    }
+
+    bool
+    defer(void (*function)()) noexcept
+    {
+	return defer(call_function, reinterpret_cast<void*>(function));
+    }
+
+    // Same as defer(), for use in interrupt handlers
+    bool
+    defer_from_isr(void (*function)(void*), void* context = nullptr) noexcept
+    {
+	return deferred.push({ function, context });
+    }
+
+    bool
+    defer_from_isr(void (*function)()) noexcept
+    {
+	return defer_from_isr(call_function, reinterpret_cast<void*>(function));
+    }
+#endif
+
+    // Time left until timer expires (0 if it is due, or its handler is
+    // running); paused timers report the time they will have left when
+    // resumed
+    // returns an empty optional if the handle is not valid
+    detail::optional<Timepoint>
+    remaining(TimerHandle handle) const noexcept
+    {
+	if (!handle || !handle.value().get()) {
+	    return detail::nullopt;
+	}
+
+	auto& timer = handle.value().get();
+
+	switch (timer.state) {
+	case TimerState::armed:
+	    return remaining_time(timer, clock::now(), postponement(timer));
+	case TimerState::paused:
+	    return expiration(timer);
+	default:
+	    return 0;
+	}
+    }
+
+    // Time at which timer expires (or expired, if its handler is running)
+    // returns an empty optional if the handle is not valid or the timer
+    // is paused
+    detail::optional<Timepoint>
+    deadline(TimerHandle handle) const noexcept
+    {
+	if (!handle || !handle.value().get() || handle.value().get().state == TimerState::paused) {
+	    return detail::nullopt;
+	}
+
+	auto& timer = handle.value().get();
+
+	return expiration(timer) + postponement(timer);
+    }
+
+    // Time until the next timer expiration (0 if a timer is overdue or a
+    // deferred call is queued), empty if no timers are armed: the value
+    // tick() would return, without running any handlers
+    detail::optional<Timepoint>
+    next_expiration() noexcept
+    {
+#ifdef TIMERSET_DEFERRED_CALLS
+	if (!deferred.empty()) {
+	    return 0;
+	}
+#endif
+
+	Timepoint now = clock::now();
+
+	if (!earliest_known) {
+	    earliest = nullptr;
+
+	    for (auto& timer: timers) {
+		if (timer.state == TimerState::armed &&
+		    (!earliest || remaining_time(timer, now) < remaining_time(*earliest, now))) {
+		    earliest = &timer;
+		}
+	    }
+
+	    earliest_known = true;
+	}
+
+	if (!earliest) {
+	    return detail::nullopt;
+	}
+
+	return remaining_time(*earliest, now);
+    }
+
+    // Ticks the timerset forward - call this function in loop()
+    // returns time until next timer expiration (0 if one is already due),
+    // empty if no timers are armed
+    detail::optional<Timepoint>
+    tick() noexcept
+    {
+	return tick_timers([this](Timer& timer, Timepoint now) {
+			       timer.state = TimerState::running;
+			       complete(timer, now, timer.handler());
+			   });
+    }
+
+    // Ticks the timerset forward, handing expired timers to a worker pool
+    // (see arduino-timer-cpp17-workers.hpp) instead of running them here;
+    // results of handlers which have finished since the last call are
+    // applied first, and the handlers of timers which expire while the
+    // pool is full are run here, so they are not delayed (or starved by
+    // timers in earlier slots) until a worker is free
+    // returns time until next timer expiration, empty if no timers are
+    // armed (timers whose handlers are running on the pool are not)
+    template <typename Pool>
+    detail::optional<Timepoint>
+    tick(Pool& pool) noexcept
+    {
+	pool.drain(this, [this](Timer& timer, Timepoint now, HandlerResult result) {
+			     complete(timer, now, result);
+			 });
+
+	return tick_timers([this, &pool](Timer& timer, Timepoint now) {
+			       timer.state = TimerState::running;
+
+			       if (pool.submit(this, timer, now)) {
+				   changed(timer, now);
+			       } else {
+				   complete(timer, now, timer.handler());
+			       }
+			   });
+    }
+
+    // Ticks the timerset forward, then delays until next timer is due;
+    // if no timers are armed, waits for an interrupt instead
+    void
+    tick_and_delay() noexcept
+    {
+	auto next = tick();
+
+#ifdef TIMERSET_TRACE
+	tracebuffer.record(clock::now(), TraceEventType::idle, 0,
+			   next ? *next : TraceEvent::forever);
+#endif
+
+	if (next) {
+	    clock::delay(*next);
+	} else {
+	    wait_for_interrupt<clock>();
+	}
+    }
+
+    // Ticks the timerset forward using a worker pool, then waits until
+    // next timer is due or a handler running on the pool finishes (if no
+    // timers are armed, only the latter)
+    template <typename Pool>
+    void
+    tick_and_delay(Pool& pool) noexcept
+    {
+	auto next = tick(pool);
+
+#ifdef TIMERSET_TRACE
+	tracebuffer.record(clock::now(), TraceEventType::idle, 0,
+			   next ? *next : TraceEvent::forever);
+#endif
+
+	pool.template wait<clock>(this, next);
+    }
+};
+
+// TimerSet whose timers all call the same type of function object F,
+// which is stored directly in the timer slots instead of in a Handler
+// (no type erasure or indirect call); F must be default constructible,
+// and return a HandlerResult or TimerStatus when called without arguments
+template <
+    typename F, // handler type
+    size_t max_timers = TIMERSET_DEFAULT_TIMERS, // max number of timers
+    typename clock = Clock::millis // clock for timers
+    >
+using TypedTimerSet = TimerSet<max_timers, clock, F>;
+
+// TimerSet without timer slots of its own, which takes them from a
+// TimerSlotPool shared with other TimerSets (passed to its constructor)
+template <
+    typename clock = Clock::millis, // clock for timers
+    typename handler_type = BasicHandler<decltype(clock::now())> // handler type, as for TypedTimerSet
+    >
+using SharedTimerSet = TimerSet<0, clock, handler_type>;
+
+// create TimerSet with default settings; defined here rather than in a
+// source file of its own, so it is compiled with the application's
+// TIMERSET_ definitions
+inline
+TimerSet<>
+create_default() noexcept
+{
+    return TimerSet<>();
+}
+
+// Ticks several TimerSets, which may use different clocks (such as one
+// with Clock::millis and one with Clock::micros), and combines their next
+// expirations in ticks of the finest of their clocks, so that a single
+// tick_and_delay() can be used for all of them
+template <typename... Sets>
+class TimerGroupTicker
+{
+    static_assert(sizeof...(Sets) > 0, "at least one TimerSet is required");
+
+    template <bool first_finer, typename First, typename Second>
+    struct finer { using type = First; };
+
+    template <typename First, typename Second>
+    struct finer<false, First, Second> { using type = Second; };
+
+    template <typename First, typename... Rest>
+    struct finest { using type = First; };
+
+    template <typename First, typename Second, typename... Rest>
+    struct finest<First, Second, Rest...>
+	: finest<typename finer<(First::ticks_per_second >= Second::ticks_per_second), First, Second>::type, Rest...> {};
+
+public:
+    // clock with the most ticks per second, used for the combined time
+    using clock_type = typename finest<typename Sets::clock_type...>::type;
+    using Timepoint = decltype(clock_type::now());
+
+private:
+    struct Member
+    {
+	void* set;
+	void (*tick)(void*);
+	detail::optional<Timepoint> (*next_expiration)(void*);
+    };
+
+    detail::array<Member, sizeof...(Sets)> members;
+
+    template <typename Set>
+    static
+    void
+    tick_set(void* set) noexcept
+    {
+	static_cast<Set*>(set)->tick();
+    }
+
+    // Next expiration of set, converted to ticks of clock_type (rounded
+    // down, and limited to the range of Timepoint)
+    template <typename Set>
+    static
+    detail::optional<Timepoint>
+    next_expiration_of(void* set) noexcept
+    {
+	constexpr uint64_t from = Set::clock_type::ticks_per_second;
+	constexpr uint64_t to = clock_type::ticks_per_second;
+
+	auto next = static_cast<Set*>(set)->next_expiration();
+
+	if (!next) {
+	    return detail::nullopt;
+	}
+
+	uint64_t ticks = *next;
+
+	if (from != to) {
+	    ticks = ticks > detail::numeric_limits<uint64_t>::max() / to
+		? detail::numeric_limits<uint64_t>::max()
+		: ticks * to / from;
+	}
+
+	if (ticks > detail::numeric_limits<Timepoint>::max()) {
+	    return detail::numeric_limits<Timepoint>::max();
+	}
+
+	return static_cast<Timepoint>(ticks);
+    }
+
+public:
+    // the TimerSets must outlive the ticker
+    TimerGroupTicker(Sets&... sets) noexcept
+	: members{{ { &sets, tick_set<Sets>, next_expiration_of<Sets> }... }}
+    {
+    }
+
+    // Earliest next expiration of the TimerSets, in ticks of clock_type
+    // (0 if a timer is due), empty if none of them has armed timers
+    detail::optional<Timepoint>
+    next_expiration() noexcept
+    {
+	detail::optional<Timepoint> earliest;
+
+	for (auto& member: members) {
+	    auto next = member.next_expiration(member.set);
+
+	    if (next && (!earliest || *next < *earliest)) {
+		earliest = next;
+	    }
+	}
+
+	return earliest;
+    }
+
+    // Ticks each of the TimerSets, in the order they were given - call this
+    // function in loop()
+    // returns the combined next expiration, as next_expiration() does
+    detail::optional<Timepoint>
+    tick() noexcept
+    {
+	for (auto& member: members) {
+	    member.tick(member.set);
+	}
+
+	return next_expiration();
+    }
+
+    // Ticks the TimerSets, then delays until the earliest next expiration;
+    // if none of them has armed timers, waits for an interrupt instead
+    void
+    tick_and_delay() noexcept
+    {
+	auto next = tick();
+
+	if (next) {
+	    clock_type::delay(*next);
+	} else {
+	    wait_for_interrupt<clock_type>();
+	}
     }
 };
 